@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_batch, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+
+#include "app_batch.h"
+#include "app_bench.h"
+#include "app_log.h"
+#include "app_metrics.h"
+#include "app_sensor_log.h"
+#include "app_settings.h"
+#include "app_time.h"
+
+#define BATCH_STREAM_ENDP "batch"
+
+/* Worst case encoded size: map header, "ts" + uint64, "sensor" + map header,
+ * "stats" + map header, "n" + uint32, then for every channel "chN" + float32
+ * and "chN" + map of six named float32 statistics.
+ */
+#define AGG_CBOR_MAX	(1 + (6 * (5 + 5)))
+#define RECORD_CBOR_MAX (38 + (ADC_NUM_CHANNELS * (20 + AGG_CBOR_MAX)))
+#define BATCH_CBOR_MAX	(4 + (CONFIG_APP_BATCH_MAX_RECORDS * RECORD_CBOR_MAX))
+
+static struct golioth_client *client;
+
+/* Ring of records not yet acknowledged; only touched from the main loop */
+static struct sensor_record records[CONFIG_APP_BATCH_MAX_RECORDS];
+static size_t rec_head;
+static size_t rec_count;
+
+/* Records of the batch being flushed, with Unix timestamps */
+static struct sensor_record flush_recs[CONFIG_APP_BATCH_MAX_RECORDS];
+static uint8_t cbor_buf[BATCH_CBOR_MAX];
+
+/* Upload of the oldest records in the ring, which stay there until acked */
+enum flush_state {
+	FLUSH_IDLE,
+	FLUSH_IN_FLIGHT,
+	FLUSH_ACKED,
+	FLUSH_FAILED,
+};
+
+static atomic_t flush_state = ATOMIC_INIT(FLUSH_IDLE);
+/* Records at the head of the ring covered by the upload in flight */
+static size_t flush_count;
+
+/* Replay of batches stored in flash while offline */
+enum drain_state {
+	DRAIN_IDLE,
+	DRAIN_IN_FLIGHT,
+	DRAIN_ACKED,
+};
+
+#define DRAIN_RETRY_DELAY K_SECONDS(30)
+
+static void drain_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(drain_work, drain_work_handler);
+static atomic_t drain_state = ATOMIC_INIT(DRAIN_IDLE);
+
+static struct sensor_record drain_recs[CONFIG_APP_BATCH_MAX_RECORDS];
+static uint8_t drain_buf[BATCH_CBOR_MAX];
+
+static void flush_sent_handler(struct golioth_client *client, enum golioth_status status,
+			       const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+			       void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		APP_LOG_ERR_RATELIMIT("Async task failed: %d", status);
+		app_metrics_inc(METRICS_ASYNC_ERRORS);
+		atomic_set(&flush_state, FLUSH_FAILED);
+		return;
+	}
+
+	app_metrics_record_ms(METRICS_UPLOAD, (uint32_t)(uintptr_t)arg);
+
+	/* The main loop removes the records, it owns the ring */
+	atomic_set(&flush_state, FLUSH_ACKED);
+}
+
+static inline struct sensor_record *record_at(size_t i)
+{
+	return &records[(rec_head + i) % ARRAY_SIZE(records)];
+}
+
+static void drop_records(size_t n)
+{
+	rec_head = (rec_head + n) % ARRAY_SIZE(records);
+	rec_count -= n;
+}
+
+/* Apply the outcome of the last upload: drop acked records, or leave failed
+ * ones queued for the next flush, which stores them in flash if offline
+ */
+static void flush_complete(void)
+{
+	if (atomic_cas(&flush_state, FLUSH_ACKED, FLUSH_IDLE)) {
+		drop_records(flush_count);
+		flush_count = 0;
+	} else if (atomic_cas(&flush_state, FLUSH_FAILED, FLUSH_IDLE)) {
+		LOG_WRN("Batch upload failed, keeping %zu records for retry", flush_count);
+		flush_count = 0;
+	}
+}
+
+int app_batch_add(const struct sensor_record *rec)
+{
+	flush_complete();
+
+	if (rec_count == ARRAY_SIZE(records)) {
+		APP_LOG_WRN_RATELIMIT("Batch queue full, dropping oldest record");
+		app_metrics_inc(METRICS_RECORDS_DROPPED);
+		drop_records(1);
+
+		/* The oldest records may be part of the upload in flight */
+		if (flush_count > 0) {
+			flush_count--;
+		}
+	}
+
+	*record_at(rec_count) = *rec;
+	rec_count++;
+
+	return 0;
+}
+
+bool app_batch_ready(void)
+{
+	int64_t age_ms;
+
+	flush_complete();
+
+	if ((rec_count == 0) || (atomic_get(&flush_state) != FLUSH_IDLE)) {
+		return false;
+	}
+
+	if (rec_count >= get_batch_size()) {
+		return true;
+	}
+
+	age_ms = k_uptime_get() - record_at(0)->ts_ms;
+
+	return age_ms >= ((int64_t)get_batch_max_age_s() * MSEC_PER_SEC);
+}
+
+static bool encode_agg(zcbor_state_t *zse, const struct ch_agg *agg)
+{
+	return zcbor_map_start_encode(zse, 6) &&
+	       zcbor_tstr_put_lit(zse, "min") &&
+	       zcbor_float32_put(zse, agg->min_ua / 1000000.0f) &&
+	       zcbor_tstr_put_lit(zse, "max") &&
+	       zcbor_float32_put(zse, agg->max_ua / 1000000.0f) &&
+	       zcbor_tstr_put_lit(zse, "mean") &&
+	       zcbor_float32_put(zse, agg->mean_ua / 1000000.0f) &&
+	       zcbor_tstr_put_lit(zse, "rms") &&
+	       zcbor_float32_put(zse, agg->rms_ua / 1000000.0f) &&
+	       zcbor_tstr_put_lit(zse, "p95") &&
+	       zcbor_float32_put(zse, agg->p95_ua / 1000000.0f) &&
+	       zcbor_tstr_put_lit(zse, "p99") &&
+	       zcbor_float32_put(zse, agg->p99_ua / 1000000.0f) &&
+	       zcbor_map_end_encode(zse, 6);
+}
+
+/* Encode records with resolved Unix timestamps as one CBOR array */
+static int encode_batch(const struct sensor_record *recs, size_t n, uint8_t *buf, size_t size,
+			size_t *len)
+{
+	bool ok;
+
+	ZCBOR_STATE_E(zse, 4, buf, size, 1);
+
+	ok = zcbor_list_start_encode(zse, n);
+
+	for (size_t i = 0; ok && (i < n); i++) {
+		ok = zcbor_map_start_encode(zse, 3) &&
+		     zcbor_tstr_put_lit(zse, "ts") &&
+		     zcbor_uint64_put(zse, recs[i].ts_ms) &&
+		     zcbor_tstr_put_lit(zse, "sensor") &&
+		     zcbor_map_start_encode(zse, ADC_NUM_CHANNELS);
+
+		for (size_t ch = 0; ok && (ch < ADC_NUM_CHANNELS); ch++) {
+			const char *key = app_sensors_ch_key(ch);
+
+			ok = zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+			     zcbor_float32_put(zse, recs[i].ua[ch] / 1000000.0f);
+		}
+
+		ok = ok && zcbor_map_end_encode(zse, ADC_NUM_CHANNELS) &&
+		     zcbor_tstr_put_lit(zse, "stats") &&
+		     zcbor_map_start_encode(zse, 1 + ADC_NUM_CHANNELS) &&
+		     zcbor_tstr_put_lit(zse, "n") &&
+		     zcbor_uint32_put(zse, recs[i].agg_count);
+
+		for (size_t ch = 0; ok && (ch < ADC_NUM_CHANNELS); ch++) {
+			const char *key = app_sensors_ch_key(ch);
+
+			ok = zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+			     encode_agg(zse, &recs[i].agg[ch]);
+		}
+
+		ok = ok && zcbor_map_end_encode(zse, 1 + ADC_NUM_CHANNELS) &&
+		     zcbor_map_end_encode(zse, 3);
+	}
+
+	ok = ok && zcbor_list_end_encode(zse, n);
+	if (!ok) {
+		LOG_ERR("Failed to encode batch: %d", zcbor_peek_error(zse));
+		return -ENOMEM;
+	}
+
+	*len = zse->payload - buf;
+
+	return 0;
+}
+
+static int send_batch(const struct sensor_record *recs, size_t n, uint8_t *buf, size_t size,
+		      golioth_set_cb_fn callback)
+{
+	uint64_t t = app_bench_start();
+	size_t len;
+	int err;
+
+	err = encode_batch(recs, n, buf, size, &len);
+	app_bench_stop(BENCH_ENCODE_BATCH, t);
+	if (err) {
+		return err;
+	}
+
+	/* The callback gets the enqueue time to measure the round trip */
+	t = app_bench_start();
+	err = golioth_stream_set_async(client,
+				       BATCH_STREAM_ENDP,
+				       GOLIOTH_CONTENT_TYPE_CBOR,
+				       buf,
+				       len,
+				       callback,
+				       (void *)(uintptr_t)app_metrics_now_ms());
+	app_bench_stop(BENCH_ENQUEUE, t);
+	if (err) {
+		LOG_ERR("Failed to send batch to Golioth: %d", err);
+		app_metrics_inc(METRICS_ENQUEUE_FAILED);
+		return err;
+	}
+
+	LOG_DBG("Streamed %zu records in %zu bytes", n, len);
+
+	return 0;
+}
+
+int app_batch_flush(void)
+{
+	size_t n;
+	int err;
+
+	flush_complete();
+
+	/* Records queued meanwhile go out once the upload in flight is acked */
+	if (atomic_get(&flush_state) != FLUSH_IDLE) {
+		return 0;
+	}
+
+	n = rec_count;
+	if (n == 0) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		flush_recs[i] = *record_at(i);
+
+		if (app_time_uptime_to_unix_ms(&flush_recs[i].ts_ms)) {
+			APP_LOG_WRN_RATELIMIT("Wall clock not available yet, holding %zu records",
+					      n);
+			return -EAGAIN;
+		}
+	}
+
+	if (golioth_client_is_connected(client)) {
+		/* Set before sending, the callback may run before this returns */
+		flush_count = n;
+		atomic_set(&flush_state, FLUSH_IN_FLIGHT);
+
+		err = send_batch(flush_recs, n, cbor_buf, sizeof(cbor_buf), flush_sent_handler);
+		if (err) {
+			flush_count = 0;
+			atomic_set(&flush_state, FLUSH_IDLE);
+		}
+
+		return err;
+	}
+
+	/* Without a flash log the records stay queued in RAM */
+	err = app_sensor_log_append(flush_recs, n);
+	if (err) {
+		return err;
+	}
+
+	LOG_INF("Offline, stored %zu records in flash", n);
+	drop_records(n);
+
+	return 0;
+}
+
+static void drain_sent_handler(struct golioth_client *client, enum golioth_status status,
+			       const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+			       void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		LOG_WRN("Failed to upload stored records: %d", status);
+		app_metrics_inc(METRICS_ASYNC_ERRORS);
+		atomic_set(&drain_state, DRAIN_IDLE);
+		k_work_reschedule(&drain_work, DRAIN_RETRY_DELAY);
+		return;
+	}
+
+	app_metrics_record_ms(METRICS_UPLOAD, (uint32_t)(uintptr_t)arg);
+
+	/* Remove the entry from flash on the work queue, not the client thread */
+	atomic_set(&drain_state, DRAIN_ACKED);
+	k_work_reschedule(&drain_work, K_NO_WAIT);
+}
+
+static void drain_work_handler(struct k_work *work)
+{
+	int n;
+	int err;
+
+	if (atomic_cas(&drain_state, DRAIN_ACKED, DRAIN_IDLE)) {
+		app_sensor_log_pop();
+
+		/* Rate-limit the replay so live traffic is not starved */
+		k_work_reschedule(&drain_work, K_MSEC(CONFIG_APP_SENSOR_LOG_DRAIN_INTERVAL_MS));
+		return;
+	}
+
+	if ((atomic_get(&drain_state) != DRAIN_IDLE) || !golioth_client_is_connected(client)) {
+		return;
+	}
+
+	n = app_sensor_log_peek(drain_recs, ARRAY_SIZE(drain_recs));
+	if (n <= 0) {
+		return;
+	}
+
+	atomic_set(&drain_state, DRAIN_IN_FLIGHT);
+
+	err = send_batch(drain_recs, n, drain_buf, sizeof(drain_buf), drain_sent_handler);
+	if (err) {
+		atomic_set(&drain_state, DRAIN_IDLE);
+		return;
+	}
+
+	LOG_INF("Uploading stored batch of %d records, %zu batches left", n,
+		app_sensor_log_entries() - 1);
+}
+
+void app_batch_drain_start(void)
+{
+	if (app_sensor_log_entries() > 0) {
+		k_work_reschedule(&drain_work, K_NO_WAIT);
+	}
+}
+
+void app_batch_set_client(struct golioth_client *batch_client)
+{
+	client = batch_client;
+}
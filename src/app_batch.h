@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Queue timestamped sensor records in RAM and upload them to Golioth
+ * LightDB Stream as a single CBOR array once a size or age threshold is
+ * reached. This keeps the cellular modem asleep between uploads instead
+ * of waking it for every reading.
+ *
+ * Records stay in RAM until Golioth acknowledges their upload, so a failed
+ * upload is retried with the next flush. Batches that cannot be uploaded
+ * while offline are handed to the flash sensor log and replayed, oldest
+ * first, once the client reconnects.
+ *
+ * https://docs.golioth.io/data-routing/
+ */
+
+#ifndef __APP_BATCH_H__
+#define __APP_BATCH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <golioth/client.h>
+
+#include "app_sensors.h"
+
+struct sensor_record {
+	/* k_uptime_get() while queued in RAM, Unix time in ms once resolved */
+	int64_t ts_ms;
+	/* RMS current per channel in microamps */
+	uint32_t ua[ADC_NUM_CHANNELS];
+	/* RMS windows since the previous record, summarised in agg */
+	uint32_t agg_count;
+	struct ch_agg agg[ADC_NUM_CHANNELS];
+};
+
+int app_batch_add(const struct sensor_record *rec);
+bool app_batch_ready(void);
+int app_batch_flush(void);
+void app_batch_drain_start(void);
+void app_batch_set_client(struct golioth_client *batch_client);
+
+#endif /* __APP_BATCH_H__ */
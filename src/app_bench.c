@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_bench, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef CONFIG_BOARD_NATIVE_SIM
+#include <posix_board_if.h>
+#else
+#include <zephyr/timing/timing.h>
+#endif
+
+#include "app_bench.h"
+#include "app_sensors.h"
+
+#ifdef CONFIG_APP_MCP3201_EMUL
+#include "mcp3201_emul.h"
+#endif
+
+#ifdef CONFIG_BOARD_NATIVE_SIM
+/* src/app_bench_host.c, linked into the native_sim runner */
+uint64_t app_bench_host_ns(void);
+#endif
+
+struct bench_stats {
+	uint32_t count;
+	uint64_t total;
+	uint64_t min;
+	uint64_t max;
+};
+
+static const char *const stage_names[BENCH_STAGES] = {
+	[BENCH_SPI] = "spi",
+	[BENCH_DECODE] = "decode",
+	[BENCH_WINDOW] = "window",
+	[BENCH_REPORT] = "report",
+	[BENCH_ENCODE_BATCH] = "encode_batch",
+	[BENCH_ENCODE_STATE] = "encode_state",
+	[BENCH_ENQUEUE] = "enqueue",
+};
+
+static struct bench_stats stats[BENCH_STAGES];
+static struct k_spinlock stats_lock;
+
+static void done_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(done_work, done_work_handler);
+
+uint64_t app_bench_start(void)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+	return app_bench_host_ns();
+#else
+	return timing_counter_get();
+#endif
+}
+
+void app_bench_stop(enum bench_stage stage, uint64_t start)
+{
+	uint64_t elapsed = app_bench_start() - start;
+	struct bench_stats *s = &stats[stage];
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	if ((s->count == 0) || (elapsed < s->min)) {
+		s->min = elapsed;
+	}
+	s->max = MAX(s->max, elapsed);
+	s->total += elapsed;
+	s->count++;
+
+	k_spin_unlock(&stats_lock, key);
+}
+
+static uint64_t to_ns(uint64_t t)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+	return t;
+#else
+	return timing_cycles_to_ns(t);
+#endif
+}
+
+#ifdef CONFIG_APP_MCP3201_EMUL
+/* Step the emulated current through levels that cross the ON threshold,
+ * the deadband and the capture trigger, so every reporting path runs.
+ */
+static const uint16_t step_counts[] = {0, 200, 800, 1600};
+
+static void step_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(step_work, step_work_handler);
+
+static void step_work_handler(struct k_work *work)
+{
+	static size_t step;
+
+	step++;
+	for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+		mcp3201_emul_set_amplitude(ch, step_counts[(step + ch) % ARRAY_SIZE(step_counts)]);
+	}
+
+	k_work_schedule(&step_work, K_SECONDS(CONFIG_APP_BENCHMARK_STEP_S));
+}
+#endif /* CONFIG_APP_MCP3201_EMUL */
+
+static void done_work_handler(struct k_work *work)
+{
+	struct bench_stats snap[BENCH_STAGES];
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	memcpy(snap, stats, sizeof(snap));
+	k_spin_unlock(&stats_lock, key);
+
+	/* printk, not the log, so the lines are unprefixed and not dropped */
+	for (int i = 0; i < BENCH_STAGES; i++) {
+		const struct bench_stats *s = &snap[i];
+
+		printk("BENCH {\"stage\":\"%s\",\"n\":%u,\"total_ns\":%llu,\"mean_ns\":%llu,"
+		       "\"min_ns\":%llu,\"max_ns\":%llu}\n",
+		       stage_names[i], s->count, to_ns(s->total),
+		       s->count ? (to_ns(s->total) / s->count) : 0, to_ns(s->min), to_ns(s->max));
+	}
+
+	printk("BENCH {\"done\":true,\"board\":\"%s\",\"duration_s\":%d,\"sample_rate_hz\":%d,"
+	       "\"channels\":%d}\n",
+	       CONFIG_BOARD, CONFIG_APP_BENCHMARK_DURATION_S, CONFIG_APP_SAMPLE_RATE_HZ,
+	       ADC_NUM_CHANNELS);
+
+	IF_ENABLED(CONFIG_BOARD_NATIVE_SIM, (posix_exit(0);));
+}
+
+void app_bench_init(void)
+{
+#ifndef CONFIG_BOARD_NATIVE_SIM
+	timing_init();
+	timing_start();
+#endif
+
+	LOG_INF("Benchmarking for %d s", CONFIG_APP_BENCHMARK_DURATION_S);
+
+	IF_ENABLED(CONFIG_APP_MCP3201_EMUL, (k_work_schedule(&step_work, K_NO_WAIT);));
+	k_work_schedule(&done_work, K_SECONDS(CONFIG_APP_BENCHMARK_DURATION_S));
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Per-stage timing of the sensor-to-cloud path. Each stage is bracketed
+ * with app_bench_start() and app_bench_stop(), and the count, total, min
+ * and max of every stage are printed as one JSON line each, prefixed with
+ * `BENCH`, once CONFIG_APP_BENCHMARK_DURATION_S has elapsed.
+ *
+ * Timestamps come from the timing API (the CPU cycle counter) on
+ * hardware. On native_sim simulated time stands still while code runs, so
+ * the host monotonic clock is used instead.
+ */
+
+#ifndef __APP_BENCH_H__
+#define __APP_BENCH_H__
+
+#include <stdint.h>
+
+enum bench_stage {
+	/* One SPI frame, including the wait for an asynchronous transfer */
+	BENCH_SPI,
+	/* Decode a frame and add it to the RMS window */
+	BENCH_DECODE,
+	/* ON/OFF detection, energy and snapshot at the end of a window */
+	BENCH_WINDOW,
+	/* app_sensors_read_and_stream() end to end */
+	BENCH_REPORT,
+	BENCH_ENCODE_BATCH,
+	BENCH_ENCODE_STATE,
+	/* The Golioth async call that queues an upload */
+	BENCH_ENQUEUE,
+	BENCH_STAGES,
+};
+
+#ifdef CONFIG_APP_BENCHMARK
+
+uint64_t app_bench_start(void);
+void app_bench_stop(enum bench_stage stage, uint64_t start);
+void app_bench_init(void);
+
+#else /* CONFIG_APP_BENCHMARK */
+
+static inline uint64_t app_bench_start(void)
+{
+	return 0;
+}
+
+static inline void app_bench_stop(enum bench_stage stage, uint64_t start)
+{
+}
+
+static inline void app_bench_init(void)
+{
+}
+
+#endif /* CONFIG_APP_BENCHMARK */
+
+#endif /* __APP_BENCH_H__ */
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_capture, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+
+#include "app_capture.h"
+#include "app_log.h"
+#include "app_metrics.h"
+#include "app_sensors.h"
+#include "app_time.h"
+
+#define CAPTURE_STREAM_ENDP "capture"
+
+#define PRE_SAMPLES  ((CONFIG_APP_CAPTURE_PRE_MS * CONFIG_APP_SAMPLE_RATE_HZ) / MSEC_PER_SEC)
+#define POST_SAMPLES ((CONFIG_APP_CAPTURE_POST_MS * CONFIG_APP_SAMPLE_RATE_HZ) / MSEC_PER_SEC)
+#define CAPTURE_LEN  (PRE_SAMPLES + POST_SAMPLES)
+
+BUILD_ASSERT(CAPTURE_LEN <= CONFIG_APP_SAMPLE_BUFFER_LEN,
+	     "Pre and post-trigger capture must fit CONFIG_APP_SAMPLE_BUFFER_LEN samples");
+
+/* The residual of a 12-bit sample fits 14 bits: at most two varint bytes */
+#define ENCODED_MAX (2 * CAPTURE_LEN)
+
+/* Chunk header: map, "ts" + uint64, "ch" + "chN", "rate_mhz", "pre", "n"
+ * and "seq" + uint32, "last" + bool, "data" + bstr header.
+ */
+#define CHUNK_CBOR_MAX (96 + CONFIG_APP_CAPTURE_CHUNK_LEN)
+
+#define UPLOAD_RETRY_DELAY K_SECONDS(30)
+
+enum capture_state {
+	CAPTURE_IDLE,
+	/* Triggered, waiting for the post-trigger samples */
+	CAPTURE_PENDING,
+	/* Frozen in the arena until every chunk is uploaded */
+	CAPTURE_UPLOAD,
+};
+
+enum chunk_state {
+	CHUNK_IDLE,
+	CHUNK_IN_FLIGHT,
+	CHUNK_ACKED,
+};
+
+static struct golioth_client *client;
+
+static atomic_t capture_state = ATOMIC_INIT(CAPTURE_IDLE);
+static atomic_t trigger_requested;
+
+/* Only touched by the sampling thread */
+static uint32_t prev_rms_ua[ADC_NUM_CHANNELS];
+static bool prev_valid[ADC_NUM_CHANNELS];
+static uint32_t end_count;
+static int64_t trigger_ms;
+
+/* Static arena: a trigger never allocates */
+static uint16_t arena[ADC_NUM_CHANNELS][CAPTURE_LEN];
+static uint8_t encoded[ENCODED_MAX];
+static uint8_t cbor_buf[CHUNK_CBOR_MAX];
+
+/* Upload progress, only touched from the work queue */
+static struct {
+	uint8_t ch;
+	bool encoded;
+	bool ts_valid;
+	int64_t ts_ms;
+	size_t len;
+	size_t off;
+	size_t chunk;
+	uint32_t seq;
+} upload;
+
+static void upload_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(upload_work, upload_work_handler);
+static atomic_t chunk_state = ATOMIC_INIT(CHUNK_IDLE);
+
+/* Second-order delta, zigzag and LEB128 varint, see app_capture.h */
+static size_t encode_samples(const uint16_t *src, size_t n, uint8_t *dst)
+{
+	int32_t p1 = 0;
+	int32_t p2 = 0;
+	size_t len = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		int32_t r = (int32_t)src[i] - ((2 * p1) - p2);
+		uint32_t z = ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+
+		do {
+			uint8_t b = z & 0x7f;
+
+			z >>= 7;
+			dst[len++] = b | (z ? 0x80 : 0);
+		} while (z);
+
+		p2 = p1;
+		p1 = src[i];
+	}
+
+	return len;
+}
+
+/* Sampling thread */
+static void capture_start(void)
+{
+	/* The arena holds one capture: later triggers wait for the upload */
+	if (!atomic_cas(&capture_state, CAPTURE_IDLE, CAPTURE_PENDING)) {
+		return;
+	}
+
+	trigger_ms = k_uptime_get();
+	end_count = app_sensors_sample_count(0) + POST_SAMPLES;
+}
+
+void app_capture_window(uint8_t ch_num, uint32_t rms_ua)
+{
+	uint32_t prev = prev_rms_ua[ch_num];
+	bool valid = prev_valid[ch_num];
+	uint32_t step;
+
+	prev_rms_ua[ch_num] = rms_ua;
+	prev_valid[ch_num] = true;
+
+	if ((CONFIG_APP_CAPTURE_TRIGGER_MA == 0) || !valid) {
+		return;
+	}
+
+	step = (rms_ua > prev) ? (rms_ua - prev) : (prev - rms_ua);
+	if (step < (CONFIG_APP_CAPTURE_TRIGGER_MA * 1000U)) {
+		return;
+	}
+
+	if (atomic_get(&capture_state) == CAPTURE_IDLE) {
+		LOG_INF("%s stepped by %u mA, capturing", app_sensors_ch_key(ch_num), step / 1000);
+	}
+
+	capture_start();
+}
+
+void app_capture_poll(void)
+{
+	if (atomic_cas(&trigger_requested, 1, 0)) {
+		capture_start();
+	}
+
+	if (atomic_get(&capture_state) != CAPTURE_PENDING) {
+		return;
+	}
+
+	if ((int32_t)(app_sensors_sample_count(0) - end_count) < 0) {
+		return;
+	}
+
+	for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+		int err = app_sensors_get_samples(ch, arena[ch], CAPTURE_LEN);
+
+		if (err < 0) {
+			/* Not enough samples yet after boot */
+			atomic_set(&capture_state, CAPTURE_IDLE);
+			return;
+		}
+	}
+
+	atomic_set(&capture_state, CAPTURE_UPLOAD);
+	k_work_reschedule(&upload_work, K_NO_WAIT);
+}
+
+int app_capture_trigger(void)
+{
+	if (atomic_get(&capture_state) != CAPTURE_IDLE) {
+		return -EBUSY;
+	}
+
+	atomic_set(&trigger_requested, 1);
+
+	return 0;
+}
+
+static void chunk_sent_handler(struct golioth_client *client, enum golioth_status status,
+			       const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+			       void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		APP_LOG_WRN_RATELIMIT("Failed to upload capture chunk: %d", status);
+		app_metrics_inc(METRICS_ASYNC_ERRORS);
+		atomic_set(&chunk_state, CHUNK_IDLE);
+		k_work_reschedule(&upload_work, UPLOAD_RETRY_DELAY);
+		return;
+	}
+
+	atomic_set(&chunk_state, CHUNK_ACKED);
+	k_work_reschedule(&upload_work, K_NO_WAIT);
+}
+
+static int encode_chunk(size_t *len)
+{
+	const char *key = app_sensors_ch_key(upload.ch);
+	bool ok;
+
+	ZCBOR_STATE_E(zse, 1, cbor_buf, sizeof(cbor_buf), 1);
+
+	ok = zcbor_map_start_encode(zse, 8) &&
+	     zcbor_tstr_put_lit(zse, "ts") &&
+	     zcbor_uint64_put(zse, upload.ts_ms) &&
+	     zcbor_tstr_put_lit(zse, "ch") &&
+	     zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+	     zcbor_tstr_put_lit(zse, "rate_mhz") &&
+	     zcbor_uint32_put(zse, app_sensors_sample_rate_mhz()) &&
+	     zcbor_tstr_put_lit(zse, "pre") &&
+	     zcbor_uint32_put(zse, PRE_SAMPLES) &&
+	     zcbor_tstr_put_lit(zse, "n") &&
+	     zcbor_uint32_put(zse, CAPTURE_LEN) &&
+	     zcbor_tstr_put_lit(zse, "seq") &&
+	     zcbor_uint32_put(zse, upload.seq) &&
+	     zcbor_tstr_put_lit(zse, "last") &&
+	     zcbor_bool_put(zse, (upload.off + upload.chunk) >= upload.len) &&
+	     zcbor_tstr_put_lit(zse, "data") &&
+	     zcbor_bstr_encode_ptr(zse, &encoded[upload.off], upload.chunk) &&
+	     zcbor_map_end_encode(zse, 8);
+	if (!ok) {
+		LOG_ERR("Failed to encode capture chunk: %d", zcbor_peek_error(zse));
+		return -ENOMEM;
+	}
+
+	*len = zse->payload - cbor_buf;
+
+	return 0;
+}
+
+/* Returns true once every channel has been uploaded */
+static bool upload_advance(void)
+{
+	upload.off += upload.chunk;
+	upload.seq++;
+
+	if (upload.off < upload.len) {
+		return false;
+	}
+
+	upload.ch++;
+	upload.encoded = false;
+
+	return upload.ch >= ADC_NUM_CHANNELS;
+}
+
+static void upload_work_handler(struct k_work *work)
+{
+	size_t len;
+	int err;
+
+	if (atomic_cas(&chunk_state, CHUNK_ACKED, CHUNK_IDLE) && upload_advance()) {
+		LOG_INF("Uploaded capture of %d samples per channel", CAPTURE_LEN);
+		memset(&upload, 0, sizeof(upload));
+		atomic_set(&capture_state, CAPTURE_IDLE);
+		return;
+	}
+
+	if ((atomic_get(&chunk_state) != CHUNK_IDLE) ||
+	    (atomic_get(&capture_state) != CAPTURE_UPLOAD)) {
+		return;
+	}
+
+	if (!golioth_client_is_connected(client)) {
+		k_work_reschedule(&upload_work, UPLOAD_RETRY_DELAY);
+		return;
+	}
+
+	if (!upload.ts_valid) {
+		upload.ts_ms = trigger_ms;
+		if (app_time_uptime_to_unix_ms(&upload.ts_ms)) {
+			APP_LOG_WRN_RATELIMIT("Wall clock not available yet, holding capture");
+			k_work_reschedule(&upload_work, UPLOAD_RETRY_DELAY);
+			return;
+		}
+		upload.ts_valid = true;
+	}
+
+	if (!upload.encoded) {
+		upload.len = encode_samples(arena[upload.ch], CAPTURE_LEN, encoded);
+		upload.off = 0;
+		upload.seq = 0;
+		upload.encoded = true;
+
+		LOG_DBG("%s: %d samples compressed to %zu bytes", app_sensors_ch_key(upload.ch),
+			CAPTURE_LEN, upload.len);
+	}
+
+	upload.chunk = MIN(CONFIG_APP_CAPTURE_CHUNK_LEN, upload.len - upload.off);
+
+	err = encode_chunk(&len);
+	if (err) {
+		/* Drop the capture rather than retry a chunk that can never fit */
+		memset(&upload, 0, sizeof(upload));
+		atomic_set(&capture_state, CAPTURE_IDLE);
+		return;
+	}
+
+	atomic_set(&chunk_state, CHUNK_IN_FLIGHT);
+
+	err = golioth_stream_set_async(client,
+				       CAPTURE_STREAM_ENDP,
+				       GOLIOTH_CONTENT_TYPE_CBOR,
+				       cbor_buf,
+				       len,
+				       chunk_sent_handler,
+				       NULL);
+	if (err) {
+		LOG_ERR("Failed to send capture chunk to Golioth: %d", err);
+		app_metrics_inc(METRICS_ENQUEUE_FAILED);
+		atomic_set(&chunk_state, CHUNK_IDLE);
+		k_work_reschedule(&upload_work, UPLOAD_RETRY_DELAY);
+	}
+}
+
+void app_capture_set_client(struct golioth_client *capture_client)
+{
+	client = capture_client;
+}
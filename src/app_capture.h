@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Pre/post-trigger waveform capture. A step in the RMS current of any
+ * channel, or the `capture_waveform` RPC, freezes the raw samples around
+ * the trigger for every channel into a static arena. The captures are
+ * compressed and streamed to the `capture` path in chunks.
+ *
+ * Samples are coded as the zigzag LEB128 varint of the second-order delta
+ * (x[i] - 2 * x[i-1] + x[i-2], with x[-1] = x[-2] = 0), which keeps a
+ * 12-bit sinusoid to about one byte per sample.
+ */
+
+#ifndef __APP_CAPTURE_H__
+#define __APP_CAPTURE_H__
+
+#include <errno.h>
+#include <stdint.h>
+#include <golioth/client.h>
+
+#ifdef CONFIG_APP_CAPTURE
+
+void app_capture_window(uint8_t ch_num, uint32_t rms_ua);
+void app_capture_poll(void);
+int app_capture_trigger(void);
+void app_capture_set_client(struct golioth_client *capture_client);
+
+#else /* CONFIG_APP_CAPTURE */
+
+static inline void app_capture_window(uint8_t ch_num, uint32_t rms_ua)
+{
+}
+
+static inline void app_capture_poll(void)
+{
+}
+
+static inline int app_capture_trigger(void)
+{
+	return -ENOTSUP;
+}
+
+static inline void app_capture_set_client(struct golioth_client *capture_client)
+{
+}
+
+#endif /* CONFIG_APP_CAPTURE */
+
+#endif /* __APP_CAPTURE_H__ */
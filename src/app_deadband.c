@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_deadband, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app_deadband.h"
+#include "app_settings.h"
+
+/* Values of the last record that was sent; only touched from the main loop */
+static uint32_t last_ua[ADC_NUM_CHANNELS];
+static int64_t last_sent_ms;
+static bool primed;
+
+/* Read by the get_report_stats RPC */
+static atomic_t changed_count;
+static atomic_t heartbeat_count;
+static atomic_t suppressed_count;
+
+/* The deadband is the larger of the absolute and the relative threshold */
+static bool exceeds_deadband(uint32_t ua, uint32_t ref_ua)
+{
+	uint32_t delta = (ua > ref_ua) ? (ua - ref_ua) : (ref_ua - ua);
+	uint32_t abs_ua = (uint32_t)get_deadband_ma() * 1000;
+	uint32_t rel_ua = ((uint64_t)ref_ua * get_deadband_pct()) / 100;
+
+	return delta > MAX(abs_ua, rel_ua);
+}
+
+enum deadband_result app_deadband_check(const struct sensor_record *rec)
+{
+	enum deadband_result result = DEADBAND_SUPPRESS;
+
+	if (!primed) {
+		result = DEADBAND_CHANGED;
+	}
+
+	for (size_t ch = 0; (result == DEADBAND_SUPPRESS) && (ch < ADC_NUM_CHANNELS); ch++) {
+		if (exceeds_deadband(rec->ua[ch], last_ua[ch])) {
+			result = DEADBAND_CHANGED;
+		}
+	}
+
+	if ((result == DEADBAND_SUPPRESS) &&
+	    ((rec->ts_ms - last_sent_ms) >= ((int64_t)get_heartbeat_s() * MSEC_PER_SEC))) {
+		result = DEADBAND_HEARTBEAT;
+	}
+
+	switch (result) {
+	case DEADBAND_SUPPRESS:
+		atomic_inc(&suppressed_count);
+		return result;
+	case DEADBAND_CHANGED:
+		atomic_inc(&changed_count);
+		break;
+	case DEADBAND_HEARTBEAT:
+		atomic_inc(&heartbeat_count);
+		break;
+	}
+
+	memcpy(last_ua, rec->ua, sizeof(last_ua));
+	last_sent_ms = rec->ts_ms;
+	primed = true;
+
+	return result;
+}
+
+void app_deadband_get_stats(struct deadband_stats *stats)
+{
+	stats->changed = (uint32_t)atomic_get(&changed_count);
+	stats->heartbeat = (uint32_t)atomic_get(&heartbeat_count);
+	stats->suppressed = (uint32_t)atomic_get(&suppressed_count);
+}
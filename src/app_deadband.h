@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Report-by-exception filter for sensor records. A record is only streamed
+ * when a channel moved by more than the deadband since the last record
+ * that was sent, or when nothing has been sent for the heartbeat interval,
+ * so idle or steady loads cost next to no data.
+ */
+
+#ifndef __APP_DEADBAND_H__
+#define __APP_DEADBAND_H__
+
+#include <stdint.h>
+
+#include "app_batch.h"
+
+enum deadband_result {
+	/* Within the deadband of the last record sent */
+	DEADBAND_SUPPRESS,
+	/* At least one channel moved beyond the deadband */
+	DEADBAND_CHANGED,
+	/* Unchanged, but the heartbeat interval has elapsed */
+	DEADBAND_HEARTBEAT,
+};
+
+struct deadband_stats {
+	uint32_t changed;
+	uint32_t heartbeat;
+	uint32_t suppressed;
+};
+
+enum deadband_result app_deadband_check(const struct sensor_record *rec);
+void app_deadband_get_stats(struct deadband_stats *stats);
+
+#endif /* __APP_DEADBAND_H__ */
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_display, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <libostentus.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app_display.h"
+#include "app_sensors.h"
+
+#define SLIDE_COUNT	(FIRMWARE + 1)
+#define SLIDE_VALUE_LEN 32
+
+/* Delay between slides of the slideshow */
+#define SLIDESHOW_PERIOD_MS 30000
+
+static const struct device *o_dev = DEVICE_DT_GET_ANY(golioth_ostentus);
+
+struct slide {
+	/* Latest value from the setters, guarded by slides_lock */
+	char pending[SLIDE_VALUE_LEN];
+	/* What the faceplate shows, only touched by the work queue */
+	char sent[SLIDE_VALUE_LEN];
+};
+
+static struct slide slides[SLIDE_COUNT];
+static struct k_spinlock slides_lock;
+static ATOMIC_DEFINE(dirty, SLIDE_COUNT);
+
+static K_THREAD_STACK_DEFINE(display_stack, CONFIG_APP_DISPLAY_THREAD_STACK_SIZE);
+static struct k_work_q display_work_q;
+
+static void update_work_handler(struct k_work *work);
+static K_WORK_DEFINE(update_work, update_work_handler);
+
+static void update_work_handler(struct k_work *work)
+{
+	char value[SLIDE_VALUE_LEN];
+
+	for (int key = 0; key < SLIDE_COUNT; key++) {
+		struct slide *s = &slides[key];
+		k_spinlock_key_t lock_key;
+		int err;
+
+		if (!atomic_test_and_clear_bit(dirty, key)) {
+			continue;
+		}
+
+		lock_key = k_spin_lock(&slides_lock);
+		memcpy(value, s->pending, sizeof(value));
+		k_spin_unlock(&slides_lock, lock_key);
+
+		if (strcmp(value, s->sent) == 0) {
+			continue;
+		}
+
+		err = ostentus_slide_set(o_dev, key, value, strlen(value));
+		if (err) {
+			/* Forget what was sent so the next update is not skipped */
+			LOG_WRN("Failed to update slide %d: %d", key, err);
+			s->sent[0] = '\0';
+			continue;
+		}
+
+		memcpy(s->sent, value, sizeof(s->sent));
+	}
+}
+
+void app_display_set_text(slide_key key, const char *text)
+{
+	struct slide *s = &slides[key];
+	k_spinlock_key_t lock_key = k_spin_lock(&slides_lock);
+	bool changed = (strncmp(s->pending, text, sizeof(s->pending) - 1) != 0);
+
+	if (changed) {
+		strncpy(s->pending, text, sizeof(s->pending) - 1);
+	}
+	k_spin_unlock(&slides_lock, lock_key);
+
+	if (changed) {
+		atomic_set_bit(dirty, key);
+		/* Fails harmlessly before app_display_init(), which flushes */
+		k_work_submit_to_queue(&display_work_q, &update_work);
+	}
+}
+
+void app_display_set_current(uint8_t ch_num, uint32_t ua)
+{
+	char buf[SLIDE_VALUE_LEN];
+	/* Round to hundredths of an amp without floating point printf */
+	uint32_t centiamps = (ua + 5000) / 10000;
+
+	snprintk(buf, sizeof(buf), "%u.%02u A", centiamps / 100, centiamps % 100);
+	app_display_set_text(CH_CURRENT_SLIDE(ch_num), buf);
+}
+
+void app_display_set_ontime(uint8_t ch_num, int64_t runtime_ms)
+{
+	char buf[SLIDE_VALUE_LEN];
+
+	snprintk(buf, sizeof(buf), "%lld s", runtime_ms / MSEC_PER_SEC);
+	app_display_set_text(CH_ONTIME_SLIDE(ch_num), buf);
+}
+
+void app_display_init(const char *fw_version)
+{
+	char label[32];
+
+	/* Set up a slideshow on Ostentus
+	 *  - add up to 256 slides
+	 *  - use the enum in app_sensors.h to add new keys
+	 *  - values are updated with the app_display_set_*() functions
+	 */
+	for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+		snprintk(label, sizeof(label), CH_CUR_LABEL_FMT, app_sensors_ch_key(ch));
+		ostentus_slide_add(o_dev, CH_CURRENT_SLIDE(ch), label, strlen(label));
+	}
+
+	for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+		snprintk(label, sizeof(label), CH_ONTIME_LABEL_FMT, app_sensors_ch_key(ch));
+		ostentus_slide_add(o_dev, CH_ONTIME_SLIDE(ch), label, strlen(label));
+	}
+
+	IF_ENABLED(CONFIG_ALUDEL_BATTERY_MONITOR, (
+		ostentus_slide_add(o_dev,
+				   BATTERY_V,
+				   LABEL_BATTERY,
+				   strlen(LABEL_BATTERY));
+		ostentus_slide_add(o_dev,
+				   BATTERY_PCT,
+				   LABEL_BATTERY,
+				   strlen(LABEL_BATTERY));
+	));
+	ostentus_slide_add(o_dev, FIRMWARE, LABEL_FIRMWARE, strlen(LABEL_FIRMWARE));
+
+	/* Set the title of the Ostentus summary slide (optional) */
+	ostentus_summary_title(o_dev, SUMMARY_TITLE, strlen(SUMMARY_TITLE));
+
+	/* Start Ostentus slideshow */
+	ostentus_slideshow(o_dev, SLIDESHOW_PERIOD_MS);
+
+	app_display_set_text(FIRMWARE, fw_version);
+
+	k_work_queue_start(&display_work_q, display_stack, K_THREAD_STACK_SIZEOF(display_stack),
+			   CONFIG_APP_DISPLAY_THREAD_PRIORITY, NULL);
+	k_thread_name_set(&display_work_q.thread, "display");
+
+	/* Push anything set before the queue was running */
+	k_work_submit_to_queue(&display_work_q, &update_work);
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Ostentus slide updates, pushed over I2C from a low-priority work queue.
+ *
+ * The setters only record the new value and mark the slide dirty, so they
+ * never wait on the faceplate. The work queue then sends each dirty slide
+ * whose text differs from what the faceplate already shows.
+ */
+
+#ifndef __APP_DISPLAY_H__
+#define __APP_DISPLAY_H__
+
+#include <stdint.h>
+#include "app_sensors.h"
+
+#ifdef CONFIG_LIB_OSTENTUS
+
+void app_display_set_current(uint8_t ch_num, uint32_t ua);
+void app_display_set_ontime(uint8_t ch_num, int64_t runtime_ms);
+void app_display_set_text(slide_key key, const char *text);
+void app_display_init(const char *fw_version);
+
+#else /* CONFIG_LIB_OSTENTUS */
+
+static inline void app_display_set_current(uint8_t ch_num, uint32_t ua)
+{
+}
+
+static inline void app_display_set_ontime(uint8_t ch_num, int64_t runtime_ms)
+{
+}
+
+static inline void app_display_set_text(slide_key key, const char *text)
+{
+}
+
+static inline void app_display_init(const char *fw_version)
+{
+}
+
+#endif /* CONFIG_LIB_OSTENTUS */
+
+#endif /* __APP_DISPLAY_H__ */
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_events, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+
+#include "app_events.h"
+#include "app_log.h"
+#include "app_metrics.h"
+#include "app_sensors.h"
+#include "app_time.h"
+
+/* Events share the batch pipeline so each one is stored at its own time */
+#define EVENTS_STREAM_ENDP "batch"
+
+/* Map header, "ts" + uint64, "onoff" + map header, "chN" + bool */
+#define EVENT_CBOR_MAX	(32)
+#define EVENTS_CBOR_MAX (4 + (CONFIG_APP_ONOFF_EVENT_QUEUE_LEN * EVENT_CBOR_MAX))
+
+struct onoff_event {
+	int64_t uptime_ms;
+	uint8_t ch_num;
+	bool on;
+};
+
+K_MSGQ_DEFINE(onoff_msgq, sizeof(struct onoff_event), CONFIG_APP_ONOFF_EVENT_QUEUE_LEN, 8);
+
+/* Delay before retrying after a failed upload or without a wall clock */
+#define EVENTS_RETRY_DELAY K_SECONDS(5)
+
+static struct golioth_client *client;
+static uint8_t events_buf[EVENTS_CBOR_MAX];
+static atomic_t events_dropped;
+/* An upload is in flight, its events are still at the head of the queue */
+static atomic_t events_in_flight;
+
+static void events_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(events_work, events_work_handler);
+
+static void events_sent_handler(struct golioth_client *client, enum golioth_status status,
+				const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+				void *arg)
+{
+	uint32_t n = (uint32_t)(uintptr_t)arg;
+	struct onoff_event evt;
+
+	if (status != GOLIOTH_OK) {
+		APP_LOG_ERR_RATELIMIT("Failed to stream on/off events: %d", status);
+		app_metrics_inc(METRICS_ASYNC_ERRORS);
+		atomic_clear(&events_in_flight);
+		k_work_reschedule(&events_work, EVENTS_RETRY_DELAY);
+		return;
+	}
+
+	/* Only acknowledged events leave the queue */
+	for (uint32_t i = 0; i < n; i++) {
+		k_msgq_get(&onoff_msgq, &evt, K_NO_WAIT);
+	}
+
+	atomic_clear(&events_in_flight);
+
+	if (k_msgq_num_used_get(&onoff_msgq) > 0) {
+		k_work_reschedule(&events_work, K_NO_WAIT);
+	}
+}
+
+static void events_work_handler(struct k_work *work)
+{
+	struct onoff_event evt;
+	atomic_val_t dropped;
+	uint32_t n = 0;
+	size_t len;
+	bool ok;
+	int err;
+
+	if (atomic_get(&events_in_flight) || !golioth_client_is_connected(client)) {
+		return;
+	}
+
+	dropped = atomic_clear(&events_dropped);
+	if (dropped) {
+		LOG_WRN("Event queue overflowed, %ld on/off events dropped", dropped);
+	}
+
+	ZCBOR_STATE_E(zse, 3, events_buf, sizeof(events_buf), 1);
+
+	ok = zcbor_list_start_encode(zse, CONFIG_APP_ONOFF_EVENT_QUEUE_LEN);
+
+	/* Only the callback of our own upload removes events, so peeking by
+	 * index is stable
+	 */
+	while (ok && (k_msgq_peek_at(&onoff_msgq, &evt, n) == 0)) {
+		const char *key = app_sensors_ch_key(evt.ch_num);
+		int64_t ts = evt.uptime_ms;
+
+		if (app_time_uptime_to_unix_ms(&ts)) {
+			APP_LOG_WRN_RATELIMIT("Wall clock not available yet, "
+					      "holding on/off events");
+			k_work_reschedule(&events_work, EVENTS_RETRY_DELAY);
+			return;
+		}
+
+		ok = zcbor_map_start_encode(zse, 2) &&
+		     zcbor_tstr_put_lit(zse, "ts") &&
+		     zcbor_uint64_put(zse, ts) &&
+		     zcbor_tstr_put_lit(zse, "onoff") &&
+		     zcbor_map_start_encode(zse, 1) &&
+		     zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+		     zcbor_bool_put(zse, evt.on) &&
+		     zcbor_map_end_encode(zse, 1) &&
+		     zcbor_map_end_encode(zse, 2);
+		n++;
+	}
+
+	if (n == 0) {
+		return;
+	}
+
+	ok = ok && zcbor_list_end_encode(zse, CONFIG_APP_ONOFF_EVENT_QUEUE_LEN);
+	if (!ok) {
+		LOG_ERR("Failed to encode on/off events: %d", zcbor_peek_error(zse));
+		return;
+	}
+
+	len = zse->payload - events_buf;
+
+	/* Set before sending, the callback may run before this returns */
+	atomic_set(&events_in_flight, 1);
+
+	err = golioth_stream_set_async(client,
+				       EVENTS_STREAM_ENDP,
+				       GOLIOTH_CONTENT_TYPE_CBOR,
+				       events_buf,
+				       len,
+				       events_sent_handler,
+				       (void *)(uintptr_t)n);
+	if (err) {
+		LOG_ERR("Failed to send on/off events: %d", err);
+		app_metrics_inc(METRICS_ENQUEUE_FAILED);
+		atomic_clear(&events_in_flight);
+		k_work_reschedule(&events_work, EVENTS_RETRY_DELAY);
+	}
+}
+
+void app_events_push(uint8_t ch_num, bool on, int64_t uptime_ms)
+{
+	struct onoff_event evt = {
+		.uptime_ms = uptime_ms,
+		.ch_num = ch_num,
+		.on = on,
+	};
+
+	/* Called from the sampling thread: never block, count overflows */
+	if (k_msgq_put(&onoff_msgq, &evt, K_NO_WAIT) != 0) {
+		atomic_inc(&events_dropped);
+	}
+
+	k_work_reschedule(&events_work, K_NO_WAIT);
+}
+
+void app_events_flush(void)
+{
+	if (k_msgq_num_used_get(&onoff_msgq) > 0) {
+		k_work_reschedule(&events_work, K_NO_WAIT);
+	}
+}
+
+void app_events_set_client(struct golioth_client *events_client)
+{
+	client = events_client;
+}
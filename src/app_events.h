@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Queue of channel ON/OFF transitions detected by the sampling thread. Each
+ * transition is uploaded as soon as possible, carrying the time at which
+ * the load actually changed state rather than the time it was reported.
+ * Events leave the queue only once Golioth acknowledges their upload, and
+ * a failed upload is retried.
+ */
+
+#ifndef __APP_EVENTS_H__
+#define __APP_EVENTS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <golioth/client.h>
+
+void app_events_push(uint8_t ch_num, bool on, int64_t uptime_ms);
+void app_events_flush(void);
+void app_events_set_client(struct golioth_client *events_client);
+
+#endif /* __APP_EVENTS_H__ */
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_harmonics, LOG_LEVEL_DBG);
+
+#include <math.h>
+#include <string.h>
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_CMSIS_DSP_TRANSFORM
+#include <arm_math.h>
+#endif
+
+#include "app_harmonics.h"
+#include "app_metrics.h"
+#include "app_sensors.h"
+
+#define HARMONICS_STREAM_ENDP "harmonics"
+
+#define FFT_LEN CONFIG_APP_HARMONICS_FFT_LEN
+
+BUILD_ASSERT(IS_POWER_OF_TWO(FFT_LEN), "CONFIG_APP_HARMONICS_FFT_LEN must be a power of two");
+BUILD_ASSERT(FFT_LEN <= CONFIG_APP_SAMPLE_BUFFER_LEN,
+	     "CONFIG_APP_HARMONICS_FFT_LEN must not exceed CONFIG_APP_SAMPLE_BUFFER_LEN");
+
+/* Centred 12-bit samples are shifted up to use the full Q31 range */
+#define SAMPLE_SHIFT 19
+
+/* Bins either side of a harmonic covering the main lobe of the Hann window */
+#define LOBE_BINS 2
+
+/*
+ * Both FFTs return X[k] / FFT_LEN. Summing |X|^2 over the main lobe and
+ * scaling by 16/3 (Hann coherent gain 0.5, equivalent noise bandwidth 1.5
+ * bins) gives the squared RMS amplitude independent of where the tone
+ * falls between bins.
+ */
+#define LOBE_POWER_TO_RMS_SQ (16.0f / 3.0f)
+
+/* Per channel: key, map header, "f1" and "thd" floats, "h" + array of floats */
+#define CH_CBOR_MAX	   (24 + (CONFIG_APP_HARMONICS_COUNT * 5))
+#define HARMONICS_CBOR_MAX (4 + (ADC_NUM_CHANNELS * CH_CBOR_MAX))
+
+struct harmonics {
+	/* RMS current of the fundamental and each harmonic in amps */
+	float amps[CONFIG_APP_HARMONICS_COUNT];
+	/* Total harmonic distortion of the reported harmonics in percent */
+	float thd_pct;
+};
+
+static struct golioth_client *client;
+
+static uint16_t samples[FFT_LEN];
+/* Periodic Hann window in Q31, symmetric about FFT_LEN / 2 */
+static int32_t window[(FFT_LEN / 2) + 1];
+/* Windowed Q31 input, overwritten by the CMSIS-DSP FFT */
+static int32_t windowed[FFT_LEN];
+/* Interleaved real/imaginary spectrum */
+static int32_t spectrum[2 * FFT_LEN];
+static struct harmonics results[ADC_NUM_CHANNELS];
+static uint8_t cbor_buf[HARMONICS_CBOR_MAX];
+
+#ifdef CONFIG_CMSIS_DSP_TRANSFORM
+static arm_rfft_instance_q31 rfft;
+#else
+/* cos and -sin of 2 * pi * k / FFT_LEN in Q31 */
+static int32_t twiddle[FFT_LEN / 2][2];
+#endif
+
+static void harmonics_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(harmonics_work, harmonics_work_handler);
+
+static void async_error_handler(struct golioth_client *client, enum golioth_status status,
+				const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+				void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Failed to stream harmonics: %d", status);
+		app_metrics_inc(METRICS_ASYNC_ERRORS);
+		return;
+	}
+}
+
+static int32_t float_to_q31(double v)
+{
+	return (v >= 1.0) ? INT32_MAX : (int32_t)(v * 2147483648.0);
+}
+
+static inline int32_t window_at(uint32_t n)
+{
+	return window[(n <= (FFT_LEN / 2)) ? n : (FFT_LEN - n)];
+}
+
+#ifdef CONFIG_CMSIS_DSP_TRANSFORM
+
+static int fft_init(void)
+{
+	if (arm_rfft_init_q31(&rfft, FFT_LEN, 0, 1) != ARM_MATH_SUCCESS) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void fft_run(int32_t *in)
+{
+	arm_rfft_q31(&rfft, in, spectrum);
+}
+
+#else /* CONFIG_CMSIS_DSP_TRANSFORM */
+
+static int fft_init(void)
+{
+	for (uint32_t k = 0; k < ARRAY_SIZE(twiddle); k++) {
+		double phase = (2.0 * M_PI * k) / FFT_LEN;
+
+		twiddle[k][0] = float_to_q31(cos(phase));
+		twiddle[k][1] = float_to_q31(-sin(phase));
+	}
+
+	return 0;
+}
+
+/*
+ * Radix-2 decimation in time FFT of a real Q31 input. Every stage halves
+ * its outputs so nothing overflows and the result is X[k] / FFT_LEN, the
+ * same scaling as arm_rfft_q31().
+ */
+static void fft_run(int32_t *in)
+{
+	/* Load the input in bit-reversed order */
+	for (uint32_t i = 0, j = 0; i < FFT_LEN; i++) {
+		uint32_t bit = FFT_LEN >> 1;
+
+		spectrum[2 * j] = in[i];
+		spectrum[(2 * j) + 1] = 0;
+
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+	}
+
+	for (uint32_t len = 2; len <= FFT_LEN; len <<= 1) {
+		uint32_t half = len >> 1;
+		uint32_t step = FFT_LEN / len;
+
+		for (uint32_t i = 0; i < FFT_LEN; i += len) {
+			for (uint32_t j = 0; j < half; j++) {
+				int32_t *a = &spectrum[2 * (i + j)];
+				int32_t *b = &spectrum[2 * (i + j + half)];
+				int64_t wr = twiddle[j * step][0];
+				int64_t wi = twiddle[j * step][1];
+				int64_t tr = ((b[0] * wr) - (b[1] * wi)) >> 31;
+				int64_t ti = ((b[0] * wi) + (b[1] * wr)) >> 31;
+
+				b[0] = (a[0] - tr) >> 1;
+				b[1] = (a[1] - ti) >> 1;
+				a[0] = (a[0] + tr) >> 1;
+				a[1] = (a[1] + ti) >> 1;
+			}
+		}
+	}
+}
+
+#endif /* CONFIG_CMSIS_DSP_TRANSFORM */
+
+static int analyze_channel(uint8_t ch_num, struct harmonics *res)
+{
+	float fundamental_bin;
+	float distortion = 0.0f;
+	uint32_t sum = 0;
+	int32_t mean;
+	int ret;
+
+	ret = app_sensors_get_samples(ch_num, samples, FFT_LEN);
+	if (ret == -EAGAIN) {
+		/* Lapped by the sampling thread while copying, try once more */
+		ret = app_sensors_get_samples(ch_num, samples, FFT_LEN);
+	}
+	if (ret < 0) {
+		return ret;
+	}
+
+	for (uint32_t n = 0; n < FFT_LEN; n++) {
+		sum += samples[n];
+	}
+	mean = sum / FFT_LEN;
+
+	for (uint32_t n = 0; n < FFT_LEN; n++) {
+		int64_t x = (int64_t)((int32_t)samples[n] - mean) << SAMPLE_SHIFT;
+
+		windowed[n] = (x * window_at(n)) >> 31;
+	}
+
+	fft_run(windowed);
+
+	fundamental_bin = ((float)CONFIG_APP_MAINS_FREQ_HZ * FFT_LEN * MSEC_PER_SEC) /
+			  app_sensors_sample_rate_mhz();
+
+	for (int h = 0; h < CONFIG_APP_HARMONICS_COUNT; h++) {
+		int32_t center = lroundf((h + 1) * fundamental_bin);
+		float power = 0.0f;
+		float rms_counts;
+
+		/* Above Nyquist for this FFT length and sample rate */
+		if ((center + LOBE_BINS) >= (FFT_LEN / 2)) {
+			res->amps[h] = 0.0f;
+			continue;
+		}
+
+		for (int32_t k = center - LOBE_BINS; k <= (center + LOBE_BINS); k++) {
+			float re = spectrum[2 * k];
+			float im = spectrum[(2 * k) + 1];
+
+			power += (re * re) + (im * im);
+		}
+
+		rms_counts = sqrtf(power * LOBE_POWER_TO_RMS_SQ) / (1 << SAMPLE_SHIFT);
+		res->amps[h] = (rms_counts * ADC_RAW_TO_NANOAMP) / 1000000000.0f;
+
+		if (h > 0) {
+			distortion += res->amps[h] * res->amps[h];
+		}
+	}
+
+	res->thd_pct = (res->amps[0] > 0.0f) ? (100.0f * sqrtf(distortion) / res->amps[0]) : 0.0f;
+
+	return 0;
+}
+
+/*
+ * {"ch0": {"f1": <A>, "thd": <%>, "h": [<A of 2nd>, <A of 3rd>, ...]}, ...}
+ */
+static int encode_harmonics(size_t *len)
+{
+	bool ok;
+
+	ZCBOR_STATE_E(zse, 3, cbor_buf, sizeof(cbor_buf), 1);
+
+	ok = zcbor_map_start_encode(zse, ADC_NUM_CHANNELS);
+
+	for (uint8_t ch = 0; ok && (ch < ADC_NUM_CHANNELS); ch++) {
+		const char *key = app_sensors_ch_key(ch);
+		const struct harmonics *res = &results[ch];
+
+		ok = zcbor_tstr_encode_ptr(zse, key, strlen(key)) &&
+		     zcbor_map_start_encode(zse, 3) &&
+		     zcbor_tstr_put_lit(zse, "f1") &&
+		     zcbor_float32_put(zse, res->amps[0]) &&
+		     zcbor_tstr_put_lit(zse, "thd") &&
+		     zcbor_float32_put(zse, res->thd_pct) &&
+		     zcbor_tstr_put_lit(zse, "h") &&
+		     zcbor_list_start_encode(zse, CONFIG_APP_HARMONICS_COUNT - 1);
+
+		for (int h = 1; ok && (h < CONFIG_APP_HARMONICS_COUNT); h++) {
+			ok = zcbor_float32_put(zse, res->amps[h]);
+		}
+
+		ok = ok && zcbor_list_end_encode(zse, CONFIG_APP_HARMONICS_COUNT - 1) &&
+		     zcbor_map_end_encode(zse, 3);
+	}
+
+	ok = ok && zcbor_map_end_encode(zse, ADC_NUM_CHANNELS);
+	if (!ok) {
+		LOG_ERR("Failed to encode harmonics: %d", zcbor_peek_error(zse));
+		return -ENOMEM;
+	}
+
+	*len = zse->payload - cbor_buf;
+
+	return 0;
+}
+
+static void harmonics_work_handler(struct k_work *work)
+{
+	int64_t start;
+	size_t len;
+	int err;
+
+	k_work_schedule(&harmonics_work, K_SECONDS(CONFIG_APP_HARMONICS_INTERVAL_S));
+
+	if (!golioth_client_is_connected(client)) {
+		return;
+	}
+
+	start = k_uptime_get();
+
+	for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+		err = analyze_channel(ch, &results[ch]);
+		if (err) {
+			LOG_WRN("No samples to analyze on %s: %d", app_sensors_ch_key(ch), err);
+			return;
+		}
+
+		LOG_DBG("%s: fundamental %d mA, THD %d.%d %%", app_sensors_ch_key(ch),
+			(int)(results[ch].amps[0] * 1000), (int)results[ch].thd_pct,
+			(int)(results[ch].thd_pct * 10) % 10);
+	}
+
+	LOG_DBG("Analyzed %d channels in %lld ms", ADC_NUM_CHANNELS, k_uptime_get() - start);
+
+	err = encode_harmonics(&len);
+	if (err) {
+		return;
+	}
+
+	err = golioth_stream_set_async(client,
+				       HARMONICS_STREAM_ENDP,
+				       GOLIOTH_CONTENT_TYPE_CBOR,
+				       cbor_buf,
+				       len,
+				       async_error_handler,
+				       NULL);
+	if (err) {
+		LOG_ERR("Failed to send harmonics to Golioth: %d", err);
+		app_metrics_inc(METRICS_ENQUEUE_FAILED);
+	}
+}
+
+void app_harmonics_start(void)
+{
+	int err;
+
+	for (uint32_t n = 0; n < ARRAY_SIZE(window); n++) {
+		window[n] = float_to_q31(0.5 * (1.0 - cos((2.0 * M_PI * n) / FFT_LEN)));
+	}
+
+	err = fft_init();
+	if (err) {
+		LOG_ERR("Failed to initialize %d point FFT: %d", FFT_LEN, err);
+		return;
+	}
+
+	LOG_INF("Harmonic analysis every %d s using a %d point %s FFT",
+		CONFIG_APP_HARMONICS_INTERVAL_S, FFT_LEN,
+		IS_ENABLED(CONFIG_CMSIS_DSP_TRANSFORM) ? "CMSIS-DSP" : "portable");
+
+	k_work_schedule(&harmonics_work, K_SECONDS(CONFIG_APP_HARMONICS_INTERVAL_S));
+}
+
+void app_harmonics_set_client(struct golioth_client *harmonics_client)
+{
+	client = harmonics_client;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Periodic harmonic analysis of the current waveform. A window of recent
+ * samples from each channel is run through a fixed-point real FFT and the
+ * fundamental, THD and low-order harmonic magnitudes are streamed to the
+ * `harmonics` path as CBOR.
+ *
+ * CMSIS-DSP is used when it is enabled, otherwise a portable radix-2 FFT
+ * with the same Q31 scaling.
+ */
+
+#ifndef __APP_HARMONICS_H__
+#define __APP_HARMONICS_H__
+
+#include <golioth/client.h>
+
+#ifdef CONFIG_APP_HARMONICS
+
+void app_harmonics_start(void);
+void app_harmonics_set_client(struct golioth_client *harmonics_client);
+
+#else /* CONFIG_APP_HARMONICS */
+
+static inline void app_harmonics_start(void)
+{
+}
+
+static inline void app_harmonics_set_client(struct golioth_client *harmonics_client)
+{
+}
+
+#endif /* CONFIG_APP_HARMONICS */
+
+#endif /* __APP_HARMONICS_H__ */
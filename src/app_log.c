@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_log, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <zephyr/logging/log_backend.h>
+#include <zephyr/logging/log_ctrl.h>
+
+#include "app_log.h"
+
+static const struct log_backend *find_golioth_backend(void)
+{
+	for (int i = 0; i < log_backend_count_get(); i++) {
+		const struct log_backend *backend = log_backend_get(i);
+
+		if (strstr(backend->name, "golioth")) {
+			return backend;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * The Golioth SDK enables its backend at the maximum level, which resets
+ * every per-source filter, so this is applied again on every connection.
+ */
+void app_log_cloud_filter_apply(void)
+{
+	const struct log_backend *backend = find_golioth_backend();
+	uint32_t sources = log_src_cnt_get(Z_LOG_LOCAL_DOMAIN_ID);
+
+	if (!backend) {
+		LOG_WRN("Golioth log backend not found");
+		return;
+	}
+
+	for (uint32_t src = 0; src < sources; src++) {
+		log_filter_set(backend, Z_LOG_LOCAL_DOMAIN_ID, src, CONFIG_APP_LOG_CLOUD_LEVEL);
+	}
+
+	LOG_DBG("Cloud log level capped at %d for %u sources", CONFIG_APP_LOG_CLOUD_LEVEL, sources);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Logging for messages that can repeat at the sample or report rate.
+ *
+ * APP_LOG_*_RATELIMIT() logs at most once per CONFIG_APP_LOG_RATELIMIT_MS
+ * from each call site. A rate-limited message reports how many were
+ * suppressed since the last one it logged, and every suppressed message is
+ * also counted in the log_suppressed metric. The format must be a string
+ * literal.
+ *
+ * A call site inside a loop over channels uses APP_LOG_*_RATELIMIT_ON()
+ * with an array of struct app_log_limit, so one channel's message does
+ * not suppress the others'.
+ *
+ * The state is updated without a lock, so concurrent callers of one site
+ * can at worst log one extra message.
+ */
+
+#ifndef __APP_LOG_H__
+#define __APP_LOG_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app_metrics.h"
+
+/* Limiter state, one per call site or per instance logged from one site */
+struct app_log_limit {
+	int64_t next_ms;
+	atomic_t suppressed;
+};
+
+#define APP_LOG_RATELIMIT_ON(_log, _limit, fmt, ...)                                               \
+	do {                                                                                       \
+		struct app_log_limit *_l = (_limit);                                               \
+		int64_t _now = k_uptime_get();                                                     \
+                                                                                                   \
+		if (_now < _l->next_ms) {                                                          \
+			atomic_inc(&_l->suppressed);                                               \
+			app_metrics_inc(METRICS_LOG_SUPPRESSED);                                   \
+			break;                                                                     \
+		}                                                                                  \
+		_l->next_ms = _now + CONFIG_APP_LOG_RATELIMIT_MS;                                  \
+                                                                                                   \
+		atomic_val_t _n = atomic_clear(&_l->suppressed);                                   \
+                                                                                                   \
+		if (_n) {                                                                          \
+			_log(fmt " (%ld suppressed)", ##__VA_ARGS__, (long)_n);                    \
+		} else {                                                                           \
+			_log(fmt, ##__VA_ARGS__);                                                  \
+		}                                                                                  \
+	} while (0)
+
+#define APP_LOG_RATELIMIT(_log, fmt, ...)                                                          \
+	do {                                                                                       \
+		static struct app_log_limit _site;                                                 \
+                                                                                                   \
+		APP_LOG_RATELIMIT_ON(_log, &_site, fmt, ##__VA_ARGS__);                            \
+	} while (0)
+
+#define APP_LOG_ERR_RATELIMIT(...) APP_LOG_RATELIMIT(LOG_ERR, __VA_ARGS__)
+#define APP_LOG_WRN_RATELIMIT(...) APP_LOG_RATELIMIT(LOG_WRN, __VA_ARGS__)
+#define APP_LOG_INF_RATELIMIT(...) APP_LOG_RATELIMIT(LOG_INF, __VA_ARGS__)
+#define APP_LOG_DBG_RATELIMIT(...) APP_LOG_RATELIMIT(LOG_DBG, __VA_ARGS__)
+
+#define APP_LOG_WRN_RATELIMIT_ON(...) APP_LOG_RATELIMIT_ON(LOG_WRN, __VA_ARGS__)
+#define APP_LOG_DBG_RATELIMIT_ON(...) APP_LOG_RATELIMIT_ON(LOG_DBG, __VA_ARGS__)
+
+#ifdef CONFIG_APP_LOG_CLOUD_FILTER
+
+/* Cap the level of messages sent to Golioth, for every log source */
+void app_log_cloud_filter_apply(void);
+
+#else /* CONFIG_APP_LOG_CLOUD_FILTER */
+
+static inline void app_log_cloud_filter_apply(void)
+{
+}
+
+#endif /* CONFIG_APP_LOG_CLOUD_FILTER */
+
+#endif /* __APP_LOG_H__ */
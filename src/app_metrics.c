@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_metrics, LOG_LEVEL_DBG);
+
+#include <string.h>
+#include <golioth/client.h>
+#include <golioth/stream.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+
+#include "app_metrics.h"
+
+#define METRICS_STREAM_ENDP "metrics"
+
+/* Worst case encoded sizes, with a one byte header per key. Histogram
+ * names are at most 8 characters and other keys at most 15. A count is a
+ * uint64 and a latency a uint32.
+ */
+#define METRICS_HIST_KEY_MAX  9
+#define METRICS_KEY_MAX	      16
+#define METRICS_UPTIME_CBOR   (9 + 5)
+#define METRICS_COUNTERS_CBOR (METRICS_COUNTERS * (METRICS_KEY_MAX + 9))
+
+/* Full histogram: list of [k, count] pairs, then <name>_max_us */
+#define METRICS_HIST_CBOR \
+	(METRICS_HIST_KEY_MAX + 3 + (METRICS_BUCKETS * (1 + 9)) + METRICS_KEY_MAX + 5)
+
+/* Summary: map of "n" with a uint64, then "p50_us", "p99_us" and "max_us" */
+#define METRICS_SUMMARY_CBOR (METRICS_HIST_KEY_MAX + 1 + (2 + 9) + (3 * (7 + 5)))
+
+#define METRICS_CBOR_MAX \
+	(3 + METRICS_UPTIME_CBOR + (METRICS_HISTS * METRICS_HIST_CBOR) + METRICS_COUNTERS_CBOR)
+
+/* Room left for the id, status code and detail key the RPC service adds */
+#define METRICS_RPC_ENVELOPE 64
+
+BUILD_ASSERT(METRICS_UPTIME_CBOR + (METRICS_HISTS * METRICS_SUMMARY_CBOR) +
+			     METRICS_COUNTERS_CBOR + METRICS_RPC_ENVELOPE <=
+		     CONFIG_GOLIOTH_RPC_MAX_RESPONSE_LEN,
+	     "get_metrics response may not fit CONFIG_GOLIOTH_RPC_MAX_RESPONSE_LEN");
+
+static const char *const hist_names[METRICS_HISTS] = {
+	[METRICS_ACQ] = "acq",
+	[METRICS_SPI_WAIT] = "spi_wait",
+	[METRICS_REPORT] = "report",
+	[METRICS_UPLOAD] = "upload",
+};
+
+static const char *const hist_max_names[METRICS_HISTS] = {
+	[METRICS_ACQ] = "acq_max_us",
+	[METRICS_SPI_WAIT] = "spi_wait_max_us",
+	[METRICS_REPORT] = "report_max_us",
+	[METRICS_UPLOAD] = "upload_max_us",
+};
+
+static const char *const counter_names[METRICS_COUNTERS] = {
+	[METRICS_ACQ_MISSED] = "acq_missed",
+	[METRICS_SPI_ERRORS] = "spi_errors",
+	[METRICS_SPI_TIMEOUTS] = "spi_timeouts",
+	[METRICS_ENQUEUE_FAILED] = "enqueue_failed",
+	[METRICS_ASYNC_ERRORS] = "async_errors",
+	[METRICS_RECORDS_DROPPED] = "records_dropped",
+	[METRICS_LOG_SUPPRESSED] = "log_suppressed",
+};
+
+struct metrics_data {
+	uint64_t hist[METRICS_HISTS][METRICS_BUCKETS];
+	uint32_t hist_max_us[METRICS_HISTS];
+	uint64_t counters[METRICS_COUNTERS];
+};
+
+/* Counted since boot, never reset */
+static struct metrics_data data;
+static struct k_spinlock data_lock;
+
+/* Copy encoded by app_metrics_encode(), so the spinlock is held briefly */
+static struct metrics_data snap;
+static K_MUTEX_DEFINE(snap_lock);
+
+#ifdef CONFIG_TIMING_FUNCTIONS
+static uint32_t cycles_per_us;
+#endif
+
+static struct golioth_client *client;
+static uint8_t cbor_buf[METRICS_CBOR_MAX];
+
+static void stream_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(stream_work, stream_work_handler);
+
+void app_metrics_hist_add_us(enum metrics_hist h, uint32_t us)
+{
+	uint32_t bucket = (us == 0) ? 0 : MIN(32 - __builtin_clz(us), METRICS_BUCKETS - 1);
+	k_spinlock_key_t key = k_spin_lock(&data_lock);
+
+	data.hist[h][bucket]++;
+	data.hist_max_us[h] = MAX(data.hist_max_us[h], us);
+
+	k_spin_unlock(&data_lock, key);
+}
+
+void app_metrics_hist_add(enum metrics_hist h, uint32_t cycles)
+{
+#ifdef CONFIG_TIMING_FUNCTIONS
+	/* Zero until app_metrics_start() has started the counter */
+	if (cycles_per_us == 0) {
+		return;
+	}
+
+	app_metrics_hist_add_us(h, cycles / cycles_per_us);
+#else
+	app_metrics_hist_add_us(h, k_cyc_to_us_floor32(cycles));
+#endif
+}
+
+void app_metrics_add(enum metrics_counter counter, uint32_t n)
+{
+	k_spinlock_key_t key = k_spin_lock(&data_lock);
+
+	data.counters[counter] += n;
+
+	k_spin_unlock(&data_lock, key);
+}
+
+/* Upper bound in us of the bucket holding the given fraction of counts */
+static uint32_t hist_percentile_us(const struct metrics_data *d, enum metrics_hist h,
+				   uint64_t n, uint32_t pct)
+{
+	uint64_t rank = DIV_ROUND_UP(n * pct, 100);
+	uint64_t seen = 0;
+
+	for (uint32_t k = 0; k < (METRICS_BUCKETS - 1); k++) {
+		seen += d->hist[h][k];
+		if (seen >= rank) {
+			return MIN(BIT(k), d->hist_max_us[h]);
+		}
+	}
+
+	return d->hist_max_us[h];
+}
+
+/* Count, p50 and p99 from the buckets, and the maximum */
+static bool encode_hist_summary(zcbor_state_t *zse, const struct metrics_data *d,
+				enum metrics_hist h)
+{
+	uint64_t n = 0;
+
+	for (uint32_t k = 0; k < METRICS_BUCKETS; k++) {
+		n += d->hist[h][k];
+	}
+
+	return zcbor_tstr_encode_ptr(zse, hist_names[h], strlen(hist_names[h])) &&
+	       zcbor_map_start_encode(zse, 4) &&
+	       zcbor_tstr_put_lit(zse, "n") && zcbor_uint64_put(zse, n) &&
+	       zcbor_tstr_put_lit(zse, "p50_us") &&
+	       zcbor_uint32_put(zse, hist_percentile_us(d, h, n, 50)) &&
+	       zcbor_tstr_put_lit(zse, "p99_us") &&
+	       zcbor_uint32_put(zse, hist_percentile_us(d, h, n, 99)) &&
+	       zcbor_tstr_put_lit(zse, "max_us") && zcbor_uint32_put(zse, d->hist_max_us[h]) &&
+	       zcbor_map_end_encode(zse, 4);
+}
+
+/* Non-empty buckets only, flattened to [k, count, k, count, ...] */
+static bool encode_hist(zcbor_state_t *zse, const struct metrics_data *d, enum metrics_hist h)
+{
+	bool ok = zcbor_tstr_encode_ptr(zse, hist_names[h], strlen(hist_names[h])) &&
+		  zcbor_list_start_encode(zse, 2 * METRICS_BUCKETS);
+
+	for (uint32_t k = 0; ok && (k < METRICS_BUCKETS); k++) {
+		if (d->hist[h][k]) {
+			ok = zcbor_uint32_put(zse, k) && zcbor_uint64_put(zse, d->hist[h][k]);
+		}
+	}
+
+	return ok && zcbor_list_end_encode(zse, 2 * METRICS_BUCKETS) &&
+	       zcbor_tstr_encode_ptr(zse, hist_max_names[h], strlen(hist_max_names[h])) &&
+	       zcbor_uint32_put(zse, d->hist_max_us[h]);
+}
+
+/*
+ * Add every metric to an open map: the full histograms, two keys each, or
+ * one bounded summary key per histogram.
+ */
+bool app_metrics_encode(zcbor_state_t *zse, bool full)
+{
+	k_spinlock_key_t key;
+	bool ok;
+
+	k_mutex_lock(&snap_lock, K_FOREVER);
+	key = k_spin_lock(&data_lock);
+	snap = data;
+	k_spin_unlock(&data_lock, key);
+
+	ok = zcbor_tstr_put_lit(zse, "uptime_s") &&
+	     zcbor_uint32_put(zse, (uint32_t)(k_uptime_get() / MSEC_PER_SEC));
+
+	for (int h = 0; ok && (h < METRICS_HISTS); h++) {
+		ok = full ? encode_hist(zse, &snap, h) : encode_hist_summary(zse, &snap, h);
+	}
+
+	for (int c = 0; ok && (c < METRICS_COUNTERS); c++) {
+		ok = zcbor_tstr_encode_ptr(zse, counter_names[c], strlen(counter_names[c])) &&
+		     zcbor_uint64_put(zse, snap.counters[c]);
+	}
+
+	k_mutex_unlock(&snap_lock);
+
+	return ok;
+}
+
+static void stream_sent_handler(struct golioth_client *client, enum golioth_status status,
+				const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+				void *arg)
+{
+	if (status != GOLIOTH_OK) {
+		LOG_WRN("Failed to stream metrics: %d", status);
+		app_metrics_inc(METRICS_ASYNC_ERRORS);
+	}
+}
+
+static void stream_work_handler(struct k_work *work)
+{
+	size_t n_keys = 1 + (2 * METRICS_HISTS) + METRICS_COUNTERS;
+	int err;
+
+	k_work_schedule(&stream_work, K_SECONDS(CONFIG_APP_METRICS_STREAM_INTERVAL_S));
+
+	if (!golioth_client_is_connected(client)) {
+		return;
+	}
+
+	ZCBOR_STATE_E(zse, 2, cbor_buf, sizeof(cbor_buf), 1);
+
+	if (!zcbor_map_start_encode(zse, n_keys) || !app_metrics_encode(zse, true) ||
+	    !zcbor_map_end_encode(zse, n_keys)) {
+		LOG_ERR("Failed to encode metrics: %d", zcbor_peek_error(zse));
+		return;
+	}
+
+	err = golioth_stream_set_async(client,
+				       METRICS_STREAM_ENDP,
+				       GOLIOTH_CONTENT_TYPE_CBOR,
+				       cbor_buf,
+				       zse->payload - cbor_buf,
+				       stream_sent_handler,
+				       NULL);
+	if (err) {
+		LOG_ERR("Failed to send metrics to Golioth: %d", err);
+		app_metrics_inc(METRICS_ENQUEUE_FAILED);
+	}
+}
+
+void app_metrics_set_client(struct golioth_client *metrics_client)
+{
+	client = metrics_client;
+}
+
+void app_metrics_start(void)
+{
+#ifdef CONFIG_TIMING_FUNCTIONS
+	timing_init();
+	timing_start();
+	cycles_per_us = timing_freq_get_mhz();
+#endif
+
+	if (CONFIG_APP_METRICS_STREAM_INTERVAL_S > 0) {
+		k_work_schedule(&stream_work, K_SECONDS(CONFIG_APP_METRICS_STREAM_INTERVAL_S));
+	}
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Always-on latency histograms and error counters, reported by the
+ * `get_metrics` RPC and optionally streamed to the `metrics` path.
+ *
+ * Latencies are kept in log2 buckets of microseconds: bucket k counts
+ * latencies in [2^(k-1), 2^k) us, bucket 0 those under 1 us, and the last
+ * bucket everything longer. Recording is a count-leading-zeros and a 64-bit
+ * increment under a spinlock, so it is cheap enough for the sampling thread
+ * and the counts do not wrap.
+ *
+ * Short spans are timed with the CPU cycle counter through the timing API
+ * when CONFIG_TIMING_FUNCTIONS is enabled (64 MHz on the nRF9160, wrapping
+ * after 67 s), otherwise with k_cycle_get_32(), which runs from the
+ * 32.768 kHz RTC on the nRF9160 and so only resolves about 30 us. Upload
+ * round trips last up to many seconds and are timed in milliseconds with
+ * app_metrics_now_ms().
+ *
+ * The `get_metrics` RPC only returns a bounded summary of each histogram,
+ * so the response always fits CONFIG_GOLIOTH_RPC_MAX_RESPONSE_LEN. The
+ * full histograms are streamed.
+ */
+
+#ifndef __APP_METRICS_H__
+#define __APP_METRICS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <golioth/client.h>
+#include <zcbor_common.h>
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_TIMING_FUNCTIONS
+#include <zephyr/timing/timing.h>
+#endif
+
+#define METRICS_BUCKETS 24
+
+enum metrics_hist {
+	/* Servicing every channel in one sample period */
+	METRICS_ACQ,
+	/* Waiting for an asynchronous SPI transfer to complete */
+	METRICS_SPI_WAIT,
+	/* app_sensors_read_and_stream() end to end */
+	METRICS_REPORT,
+	/* From queueing a batch to its acknowledgment */
+	METRICS_UPLOAD,
+	METRICS_HISTS,
+};
+
+enum metrics_counter {
+	METRICS_ACQ_MISSED,
+	METRICS_SPI_ERRORS,
+	METRICS_SPI_TIMEOUTS,
+	/* A Golioth async call refused the request */
+	METRICS_ENQUEUE_FAILED,
+	/* A request completed with an error status */
+	METRICS_ASYNC_ERRORS,
+	/* Records dropped because the batch queue was full */
+	METRICS_RECORDS_DROPPED,
+	/* Messages held back by the rate-limited log macros */
+	METRICS_LOG_SUPPRESSED,
+	METRICS_COUNTERS,
+};
+
+#ifdef CONFIG_APP_METRICS
+
+void app_metrics_hist_add(enum metrics_hist hist, uint32_t cycles);
+void app_metrics_hist_add_us(enum metrics_hist hist, uint32_t us);
+void app_metrics_add(enum metrics_counter counter, uint32_t n);
+bool app_metrics_encode(zcbor_state_t *zse, bool full);
+void app_metrics_set_client(struct golioth_client *metrics_client);
+void app_metrics_start(void);
+
+#else /* CONFIG_APP_METRICS */
+
+static inline void app_metrics_hist_add(enum metrics_hist hist, uint32_t cycles)
+{
+}
+
+static inline void app_metrics_hist_add_us(enum metrics_hist hist, uint32_t us)
+{
+}
+
+static inline void app_metrics_add(enum metrics_counter counter, uint32_t n)
+{
+}
+
+static inline bool app_metrics_encode(zcbor_state_t *zse, bool full)
+{
+	return false;
+}
+
+static inline void app_metrics_set_client(struct golioth_client *metrics_client)
+{
+}
+
+static inline void app_metrics_start(void)
+{
+}
+
+#endif /* CONFIG_APP_METRICS */
+
+static inline uint32_t app_metrics_now(void)
+{
+	if (!IS_ENABLED(CONFIG_APP_METRICS)) {
+		return 0;
+	}
+
+#ifdef CONFIG_TIMING_FUNCTIONS
+	return (uint32_t)timing_counter_get();
+#else
+	return k_cycle_get_32();
+#endif
+}
+
+/* Add the time since start, taken with app_metrics_now() */
+static inline void app_metrics_record(enum metrics_hist hist, uint32_t start)
+{
+	if (IS_ENABLED(CONFIG_APP_METRICS)) {
+		app_metrics_hist_add(hist, app_metrics_now() - start);
+	}
+}
+
+static inline uint32_t app_metrics_now_ms(void)
+{
+	return IS_ENABLED(CONFIG_APP_METRICS) ? k_uptime_get_32() : 0;
+}
+
+/* Add the time since start, taken with app_metrics_now_ms() */
+static inline void app_metrics_record_ms(enum metrics_hist hist, uint32_t start_ms)
+{
+	if (IS_ENABLED(CONFIG_APP_METRICS)) {
+		uint32_t ms = k_uptime_get_32() - start_ms;
+
+		app_metrics_hist_add_us(hist, MIN(ms, UINT32_MAX / USEC_PER_MSEC) * USEC_PER_MSEC);
+	}
+}
+
+static inline void app_metrics_inc(enum metrics_counter counter)
+{
+	app_metrics_add(counter, 1);
+}
+
+#endif /* __APP_METRICS_H__ */
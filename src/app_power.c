@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_power, LOG_LEVEL_DBG);
+
+#include <modem/lte_lc.h>
+#include <zephyr/kernel.h>
+
+#include "app_power.h"
+
+#define RRC_IDLE_EVT BIT(0)
+
+static K_EVENT_DEFINE(modem_evt);
+static K_MUTEX_DEFINE(residency_lock);
+
+/* Totals since boot, spans in progress are added when read */
+static uint64_t acq_total_ms;
+static uint64_t rrc_total_ms;
+static uint64_t sleep_total_ms;
+static int64_t rrc_since = -1;
+static int64_t sleep_since = -1;
+
+/* Totals at the start of the current interval */
+static struct {
+	int64_t at;
+	uint64_t acq_ms;
+	uint64_t rrc_ms;
+	uint64_t sleep_ms;
+	uint64_t idle_ms;
+} mark;
+
+static struct power_residency last;
+
+static uint64_t cpu_idle_ms(void)
+{
+#ifdef CONFIG_SCHED_THREAD_USAGE_ALL
+	k_thread_runtime_stats_t stats;
+
+	if (k_thread_runtime_stats_all_get(&stats) == 0) {
+		return k_cyc_to_ms_floor64(stats.idle_cycles);
+	}
+#endif
+
+	return 0;
+}
+
+static void span_end(int64_t *since, uint64_t *total, int64_t now)
+{
+	if (*since >= 0) {
+		*total += now - *since;
+		*since = -1;
+	}
+}
+
+static void span_start(int64_t *since, int64_t now)
+{
+	if (*since < 0) {
+		*since = now;
+	}
+}
+
+static uint64_t span_total(int64_t since, uint64_t total, int64_t now)
+{
+	return (since >= 0) ? (total + (now - since)) : total;
+}
+
+static void lte_event_handler(const struct lte_lc_evt *const evt)
+{
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&residency_lock, K_FOREVER);
+
+	switch (evt->type) {
+	case LTE_LC_EVT_RRC_UPDATE:
+		if (evt->rrc_mode == LTE_LC_RRC_MODE_CONNECTED) {
+			span_start(&rrc_since, now);
+			k_event_clear(&modem_evt, RRC_IDLE_EVT);
+		} else {
+			span_end(&rrc_since, &rrc_total_ms, now);
+			k_event_post(&modem_evt, RRC_IDLE_EVT);
+		}
+		break;
+	case LTE_LC_EVT_PSM_UPDATE:
+		LOG_INF("PSM: TAU %d s, active time %d s", evt->psm_cfg.tau,
+			evt->psm_cfg.active_time);
+		break;
+	case LTE_LC_EVT_EDRX_UPDATE:
+		LOG_INF("eDRX: cycle %d ms, paging window %d ms", (int)(evt->edrx_cfg.edrx * 1000),
+			(int)(evt->edrx_cfg.ptw * 1000));
+		break;
+#ifdef CONFIG_LTE_LC_MODEM_SLEEP_NOTIFICATIONS
+	case LTE_LC_EVT_MODEM_SLEEP_ENTER:
+		span_start(&sleep_since, now);
+		break;
+	case LTE_LC_EVT_MODEM_SLEEP_EXIT:
+		span_end(&sleep_since, &sleep_total_ms, now);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	k_mutex_unlock(&residency_lock);
+}
+
+bool app_power_modem_active(void)
+{
+	return !k_event_test(&modem_evt, RRC_IDLE_EVT);
+}
+
+int app_power_wait_modem_idle(k_timeout_t timeout)
+{
+	if (k_event_wait(&modem_evt, RRC_IDLE_EVT, false, timeout) == 0) {
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+void app_power_add_acq_ms(uint32_t ms)
+{
+	k_mutex_lock(&residency_lock, K_FOREVER);
+	acq_total_ms += ms;
+	k_mutex_unlock(&residency_lock);
+}
+
+void app_power_roll_interval(void)
+{
+	struct power_residency res;
+	int64_t now = k_uptime_get();
+	uint64_t idle_ms = cpu_idle_ms();
+	uint64_t rrc_ms;
+	uint64_t sleep_ms;
+
+	k_mutex_lock(&residency_lock, K_FOREVER);
+
+	rrc_ms = span_total(rrc_since, rrc_total_ms, now);
+	sleep_ms = span_total(sleep_since, sleep_total_ms, now);
+
+	res.interval_ms = now - mark.at;
+	res.acq_ms = acq_total_ms - mark.acq_ms;
+	res.rrc_ms = rrc_ms - mark.rrc_ms;
+	res.modem_sleep_ms = sleep_ms - mark.sleep_ms;
+	res.cpu_idle_ms = idle_ms - mark.idle_ms;
+
+	mark.at = now;
+	mark.acq_ms = acq_total_ms;
+	mark.rrc_ms = rrc_ms;
+	mark.sleep_ms = sleep_ms;
+	mark.idle_ms = idle_ms;
+	last = res;
+
+	k_mutex_unlock(&residency_lock);
+
+	LOG_INF("Residency over %u ms: acquiring %u ms, RRC connected %u ms, "
+		"modem asleep %u ms, CPU idle %u ms",
+		res.interval_ms, res.acq_ms, res.rrc_ms, res.modem_sleep_ms, res.cpu_idle_ms);
+}
+
+void app_power_get_residency(struct power_residency *res)
+{
+	k_mutex_lock(&residency_lock, K_FOREVER);
+	*res = last;
+	k_mutex_unlock(&residency_lock);
+}
+
+void app_power_init(void)
+{
+	int err;
+
+	/* The radio is idle until the first RRC connection */
+	k_event_post(&modem_evt, RRC_IDLE_EVT);
+	mark.at = k_uptime_get();
+	mark.idle_ms = cpu_idle_ms();
+
+	lte_lc_register_handler(lte_event_handler);
+
+	err = lte_lc_psm_req(true);
+	if (err) {
+		LOG_WRN("Failed to request PSM: %d", err);
+	}
+
+	err = lte_lc_edrx_req(true);
+	if (err) {
+		LOG_WRN("Failed to request eDRX: %d", err);
+	}
+}
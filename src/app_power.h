@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Duty-cycled operation for battery powered units. Instead of sampling
+ * continuously, the sampling thread runs a short burst once per loop and
+ * the SPI bus is suspended in between. PSM and eDRX are requested from the
+ * modem, bursts are held off while the radio is in RRC connected mode, and
+ * records are uploaded whenever the modem is already active.
+ *
+ * The time spent acquiring, with the radio connected, with the modem
+ * asleep and with the CPU idle is measured over every loop interval.
+ */
+
+#ifndef __APP_POWER_H__
+#define __APP_POWER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/* Residency over one loop interval, all times in ms */
+struct power_residency {
+	uint32_t interval_ms;
+	/* Sampling bursts, including SPI resume and suspend */
+	uint32_t acq_ms;
+	/* Radio in RRC connected mode */
+	uint32_t rrc_ms;
+	/* Modem in PSM or an eDRX sleep, 0 without sleep notifications */
+	uint32_t modem_sleep_ms;
+	/* CPU idle thread, 0 without CONFIG_SCHED_THREAD_USAGE_ALL */
+	uint32_t cpu_idle_ms;
+};
+
+#ifdef CONFIG_APP_LOW_POWER
+
+void app_power_init(void);
+bool app_power_modem_active(void);
+int app_power_wait_modem_idle(k_timeout_t timeout);
+void app_power_add_acq_ms(uint32_t ms);
+void app_power_roll_interval(void);
+void app_power_get_residency(struct power_residency *res);
+
+#else /* CONFIG_APP_LOW_POWER */
+
+static inline void app_power_init(void)
+{
+}
+
+static inline bool app_power_modem_active(void)
+{
+	return false;
+}
+
+static inline int app_power_wait_modem_idle(k_timeout_t timeout)
+{
+	return 0;
+}
+
+static inline void app_power_add_acq_ms(uint32_t ms)
+{
+}
+
+static inline void app_power_roll_interval(void)
+{
+}
+
+static inline void app_power_get_residency(struct power_residency *res)
+{
+	*res = (struct power_residency){0};
+}
+
+#endif /* CONFIG_APP_LOW_POWER */
+
+#endif /* __APP_POWER_H__ */
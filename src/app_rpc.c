@@ -18,8 +18,13 @@ LOG_MODULE_REGISTER(app_rpc, LOG_LEVEL_DBG);
 #endif
 
 #include "main.h"
+#include "app_capture.h"
+#include "app_deadband.h"
+#include "app_metrics.h"
+#include "app_power.h"
 #include "app_sensors.h"
 #include "app_rpc.h"
+#include "app_totals.h"
 
 static void reboot_work_handler(struct k_work *work)
 {
@@ -30,6 +35,9 @@ static void reboot_work_handler(struct k_work *work)
 		k_sleep(K_SECONDS(1));
 	}
 
+	/* Keep the totals accumulated since the last periodic checkpoint */
+	app_totals_checkpoint_now();
+
 	/* Sync logs before reboot */
 	LOG_PANIC();
 
@@ -106,7 +114,11 @@ static enum golioth_rpc_status on_reset_cumulative(zcbor_state_t *request_params
 {
 	LOG_INF("Request to reset cumulative values received. Processing now.");
 	int err = reset_cumulative_totals();
-	if (0 != err)
+	if (-EBUSY == err)
+	{
+		return GOLIOTH_RPC_RESOURCE_EXHAUSTED;
+	}
+	else if (0 != err)
 	{
 		return GOLIOTH_RPC_PERMISSION_DENIED;
 	}
@@ -115,6 +127,89 @@ static enum golioth_rpc_status on_reset_cumulative(zcbor_state_t *request_params
 	return GOLIOTH_RPC_OK;
 }
 
+static enum golioth_rpc_status on_get_report_stats(zcbor_state_t *request_params_array,
+						   zcbor_state_t *response_detail_map,
+						   void *callback_arg)
+{
+	struct deadband_stats stats;
+	bool ok;
+
+	app_deadband_get_stats(&stats);
+
+	ok = zcbor_tstr_put_lit(response_detail_map, "sent_changed") &&
+	     zcbor_uint32_put(response_detail_map, stats.changed) &&
+	     zcbor_tstr_put_lit(response_detail_map, "sent_heartbeat") &&
+	     zcbor_uint32_put(response_detail_map, stats.heartbeat) &&
+	     zcbor_tstr_put_lit(response_detail_map, "suppressed") &&
+	     zcbor_uint32_put(response_detail_map, stats.suppressed);
+	if (!ok) {
+		return GOLIOTH_RPC_RESOURCE_EXHAUSTED;
+	}
+
+	return GOLIOTH_RPC_OK;
+}
+
+static enum golioth_rpc_status on_capture_waveform(zcbor_state_t *request_params_array,
+						   zcbor_state_t *response_detail_map,
+						   void *callback_arg)
+{
+	int err = app_capture_trigger();
+
+	if (-ENOTSUP == err) {
+		return GOLIOTH_RPC_UNIMPLEMENTED;
+	} else if (-EBUSY == err) {
+		/* The previous capture has not been uploaded yet */
+		return GOLIOTH_RPC_RESOURCE_EXHAUSTED;
+	}
+
+	return GOLIOTH_RPC_OK;
+}
+
+static enum golioth_rpc_status on_get_power_stats(zcbor_state_t *request_params_array,
+						  zcbor_state_t *response_detail_map,
+						  void *callback_arg)
+{
+	struct power_residency res;
+	bool ok;
+
+	if (!IS_ENABLED(CONFIG_APP_LOW_POWER)) {
+		return GOLIOTH_RPC_UNIMPLEMENTED;
+	}
+
+	app_power_get_residency(&res);
+
+	ok = zcbor_tstr_put_lit(response_detail_map, "interval_ms") &&
+	     zcbor_uint32_put(response_detail_map, res.interval_ms) &&
+	     zcbor_tstr_put_lit(response_detail_map, "acq_ms") &&
+	     zcbor_uint32_put(response_detail_map, res.acq_ms) &&
+	     zcbor_tstr_put_lit(response_detail_map, "rrc_ms") &&
+	     zcbor_uint32_put(response_detail_map, res.rrc_ms) &&
+	     zcbor_tstr_put_lit(response_detail_map, "modem_sleep_ms") &&
+	     zcbor_uint32_put(response_detail_map, res.modem_sleep_ms) &&
+	     zcbor_tstr_put_lit(response_detail_map, "cpu_idle_ms") &&
+	     zcbor_uint32_put(response_detail_map, res.cpu_idle_ms);
+	if (!ok) {
+		return GOLIOTH_RPC_RESOURCE_EXHAUSTED;
+	}
+
+	return GOLIOTH_RPC_OK;
+}
+
+static enum golioth_rpc_status on_get_metrics(zcbor_state_t *request_params_array,
+					      zcbor_state_t *response_detail_map,
+					      void *callback_arg)
+{
+	if (!IS_ENABLED(CONFIG_APP_METRICS)) {
+		return GOLIOTH_RPC_UNIMPLEMENTED;
+	}
+
+	if (!app_metrics_encode(response_detail_map, false)) {
+		return GOLIOTH_RPC_RESOURCE_EXHAUSTED;
+	}
+
+	return GOLIOTH_RPC_OK;
+}
+
 static void rpc_log_if_register_failure(int err)
 {
 	if (err) {
@@ -128,9 +223,21 @@ void app_rpc_register(struct golioth_client *client)
 
 	int err;
 
+	err = golioth_rpc_register(rpc, "capture_waveform", on_capture_waveform, NULL);
+	rpc_log_if_register_failure(err);
+
+	err = golioth_rpc_register(rpc, "get_metrics", on_get_metrics, NULL);
+	rpc_log_if_register_failure(err);
+
 	err = golioth_rpc_register(rpc, "get_network_info", on_get_network_info, NULL);
 	rpc_log_if_register_failure(err);
 
+	err = golioth_rpc_register(rpc, "get_power_stats", on_get_power_stats, NULL);
+	rpc_log_if_register_failure(err);
+
+	err = golioth_rpc_register(rpc, "get_report_stats", on_get_report_stats, NULL);
+	rpc_log_if_register_failure(err);
+
 	err = golioth_rpc_register(rpc, "reboot", on_reboot, NULL);
 	rpc_log_if_register_failure(err);
 
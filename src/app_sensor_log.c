@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_sensor_log, LOG_LEVEL_DBG);
+
+#include <zephyr/drivers/flash.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+
+#include "app_sensor_log.h"
+
+#define SENSOR_LOG_PARTITION_ID FIXED_PARTITION_ID(sensor_log)
+
+/* NVS ids: one metadata entry, then a ring of batch entries */
+#define META_ID	      1
+#define ENTRY_ID_BASE 0x100
+
+/* Room NVS keeps in each sector for its allocation table entries, with a
+ * margin for write alignment. nvs_write() rejects anything larger.
+ */
+#define NVS_SECTOR_OVERHEAD 64
+
+/* entry_id() must stay continuous when the uint32_t sequence numbers wrap */
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_APP_SENSOR_LOG_MAX_ENTRIES),
+	     "CONFIG_APP_SENSOR_LOG_MAX_ENTRIES must be a power of two");
+
+struct log_meta {
+	/* Sequence number of the next entry to be written */
+	uint32_t head;
+	/* Sequence number of the oldest entry not yet uploaded */
+	uint32_t tail;
+	/* sizeof(struct sensor_record) of the firmware that wrote the log */
+	uint32_t rec_size;
+};
+
+static struct nvs_fs fs;
+static struct log_meta meta;
+static bool log_ready;
+/* Records that fit in one NVS entry, batches are split above this */
+static size_t entry_max_recs;
+
+static K_MUTEX_DEFINE(log_mutex);
+
+static inline uint16_t entry_id(uint32_t seq)
+{
+	return ENTRY_ID_BASE + (seq % CONFIG_APP_SENSOR_LOG_MAX_ENTRIES);
+}
+
+static int write_meta(void)
+{
+	ssize_t rc = nvs_write(&fs, META_ID, &meta, sizeof(meta));
+
+	return (rc < 0) ? rc : 0;
+}
+
+static void drop_oldest(void)
+{
+	nvs_delete(&fs, entry_id(meta.tail));
+	meta.tail++;
+}
+
+int app_sensor_log_init(void)
+{
+	const struct flash_area *fa;
+	struct flash_pages_info info;
+	ssize_t rc;
+	int err;
+
+	err = flash_area_open(SENSOR_LOG_PARTITION_ID, &fa);
+	if (err) {
+		LOG_ERR("Failed to open sensor log partition: %d", err);
+		return err;
+	}
+
+	fs.flash_device = fa->fa_dev;
+	fs.offset = fa->fa_off;
+
+	err = flash_get_page_info_by_offs(fs.flash_device, fs.offset, &info);
+	if (err) {
+		LOG_ERR("Failed to get flash page info: %d", err);
+		flash_area_close(fa);
+		return err;
+	}
+
+	fs.sector_size = info.size;
+	fs.sector_count = fa->fa_size / info.size;
+	flash_area_close(fa);
+
+	if (fs.sector_size <= NVS_SECTOR_OVERHEAD + sizeof(struct sensor_record)) {
+		LOG_ERR("Flash sector of %u bytes cannot hold a sensor record", fs.sector_size);
+		return -EINVAL;
+	}
+	entry_max_recs = (fs.sector_size - NVS_SECTOR_OVERHEAD) / sizeof(struct sensor_record);
+
+	err = nvs_mount(&fs);
+	if (err) {
+		LOG_ERR("Failed to mount sensor log: %d", err);
+		return err;
+	}
+
+	/* Head and tail live in a single entry: no need to scan the log */
+	rc = nvs_read(&fs, META_ID, &meta, sizeof(meta));
+	if ((rc != sizeof(meta)) || (meta.rec_size != sizeof(struct sensor_record))) {
+		/* Records in an older layout cannot be replayed */
+		if (rc > 0) {
+			LOG_WRN("Discarding sensor log with a different record layout");
+		}
+		meta = (struct log_meta){
+			.rec_size = sizeof(struct sensor_record),
+		};
+	}
+
+	log_ready = true;
+
+	LOG_INF("Sensor log mounted, %u stored batches", meta.head - meta.tail);
+
+	return 0;
+}
+
+static int append_entry(const struct sensor_record *recs, size_t count)
+{
+	size_t len = count * sizeof(*recs);
+	ssize_t rc;
+
+	if ((meta.head - meta.tail) >= CONFIG_APP_SENSOR_LOG_MAX_ENTRIES) {
+		LOG_WRN("Sensor log full, dropping oldest batch");
+		drop_oldest();
+	}
+
+	while (true) {
+		rc = nvs_write(&fs, entry_id(meta.head), recs, len);
+		if ((rc != -ENOSPC) || (meta.head == meta.tail)) {
+			break;
+		}
+
+		/* Partition full: make room by discarding the oldest batch */
+		LOG_WRN("Sensor log out of space, dropping oldest batch");
+		drop_oldest();
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	meta.head++;
+
+	return write_meta();
+}
+
+int app_sensor_log_append(const struct sensor_record *recs, size_t count)
+{
+	int err = 0;
+
+	if (!log_ready) {
+		return -ENODEV;
+	}
+
+	k_mutex_lock(&log_mutex, K_FOREVER);
+
+	/* Batches larger than a flash sector are stored as several entries */
+	while ((count > 0) && !err) {
+		size_t n = MIN(count, entry_max_recs);
+
+		err = append_entry(recs, n);
+		recs += n;
+		count -= n;
+	}
+
+	k_mutex_unlock(&log_mutex);
+
+	return err;
+}
+
+int app_sensor_log_peek(struct sensor_record *recs, size_t max_count)
+{
+	size_t size = max_count * sizeof(*recs);
+	ssize_t rc = 0;
+
+	if (!log_ready) {
+		return 0;
+	}
+
+	k_mutex_lock(&log_mutex, K_FOREVER);
+
+	while (meta.tail != meta.head) {
+		rc = nvs_read(&fs, entry_id(meta.tail), recs, size);
+		if ((rc > 0) && ((rc % sizeof(*recs)) == 0)) {
+			break;
+		}
+
+		/* Entry lost between a delete and the metadata update, or written
+		 * by firmware with a different number of channels
+		 */
+		LOG_WRN("Skipping unreadable sensor log entry %u: %d", meta.tail, rc);
+		meta.tail++;
+		write_meta();
+		rc = 0;
+	}
+
+	k_mutex_unlock(&log_mutex);
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	return MIN((size_t)rc, size) / sizeof(*recs);
+}
+
+int app_sensor_log_pop(void)
+{
+	int err = 0;
+
+	if (!log_ready) {
+		return 0;
+	}
+
+	k_mutex_lock(&log_mutex, K_FOREVER);
+
+	if (meta.tail != meta.head) {
+		drop_oldest();
+		err = write_meta();
+	}
+
+	k_mutex_unlock(&log_mutex);
+
+	return err;
+}
+
+size_t app_sensor_log_entries(void)
+{
+	size_t entries;
+
+	k_mutex_lock(&log_mutex, K_FOREVER);
+	entries = meta.head - meta.tail;
+	k_mutex_unlock(&log_mutex);
+
+	return entries;
+}
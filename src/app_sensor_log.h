@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Persistent FIFO of sensor record batches that could not be uploaded while
+ * the device was offline. Each entry holds one batch of records with Unix
+ * timestamps, so entries can be replayed in order after a reboot.
+ *
+ * The log lives in NVS on the dedicated `sensor_log` flash partition. NVS
+ * writes sequentially through its sectors, which spreads erases evenly, and
+ * the head/tail sequence numbers are kept in their own NVS entry so they
+ * are recovered with a single lookup at boot. A batch larger than one
+ * flash sector is split into several entries, which are replayed as
+ * separate uploads.
+ */
+
+#ifndef __APP_SENSOR_LOG_H__
+#define __APP_SENSOR_LOG_H__
+
+#include <errno.h>
+#include <stddef.h>
+
+#include "app_batch.h"
+
+#ifdef CONFIG_APP_SENSOR_LOG
+
+int app_sensor_log_init(void);
+int app_sensor_log_append(const struct sensor_record *recs, size_t count);
+int app_sensor_log_peek(struct sensor_record *recs, size_t max_count);
+int app_sensor_log_pop(void);
+size_t app_sensor_log_entries(void);
+
+#else /* CONFIG_APP_SENSOR_LOG */
+
+static inline int app_sensor_log_init(void)
+{
+	return 0;
+}
+
+static inline int app_sensor_log_append(const struct sensor_record *recs, size_t count)
+{
+	return -ENOTSUP;
+}
+
+static inline int app_sensor_log_peek(struct sensor_record *recs, size_t max_count)
+{
+	return 0;
+}
+
+static inline int app_sensor_log_pop(void)
+{
+	return 0;
+}
+
+static inline size_t app_sensor_log_entries(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_APP_SENSOR_LOG */
+
+#endif /* __APP_SENSOR_LOG_H__ */
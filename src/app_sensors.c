@@ -8,6 +8,7 @@
 LOG_MODULE_REGISTER(app_sensors, LOG_LEVEL_DBG);
 
 #include <stdlib.h>
+#include <string.h>
 #include <golioth/client.h>
 #include <golioth/lightdb_state.h>
 #include <golioth/payload_utils.h>
@@ -17,230 +18,957 @@ LOG_MODULE_REGISTER(app_sensors, LOG_LEVEL_DBG);
 #include <zephyr/drivers/spi.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/sensor.h>
-
+#include <zephyr/pm/device.h>
+#include <zephyr/sys/barrier.h>
+
+#include "app_batch.h"
+#include "app_bench.h"
+#include "app_capture.h"
+#include "app_deadband.h"
+#include "app_display.h"
+#include "app_events.h"
+#include "app_log.h"
+#include "app_metrics.h"
+#include "app_power.h"
 #include "app_sensors.h"
 #include "app_state.h"
 #include "app_settings.h"
+#include "app_totals.h"
+#include "mcp3201.h"
 
-#ifdef CONFIG_LIB_OSTENTUS
-#include <libostentus.h>
-static const struct device *o_dev = DEVICE_DT_GET_ANY(golioth_ostentus);
-#endif
 #ifdef CONFIG_ALUDEL_BATTERY_MONITOR
 #include <battery_monitor.h>
 #endif
 
-#define ADC_RAW_TO_AMP (0.003529412f)
 #define SPI_OP	SPI_OP_MODE_MASTER | SPI_MODE_CPOL | SPI_MODE_CPHA | SPI_WORD_SET(8) | SPI_LINES_SINGLE
 
 static struct golioth_client *client;
 
-struct k_sem adc_data_sem;
-
-/* Formatting string for sending sensor JSON to Golioth */
-#define JSON_FMT "{\"ch0\":%d,\"ch1\":%d}"
-#define ADC_STREAM_ENDP	"sensor"
 #define ADC_CUMULATIVE_ENDP	"state/cumulative"
 
-#define ADC_CH0 0
-#define ADC_CH1 1
-
-adc_node_t adc_ch0 = {
-	.spi = SPI_DT_SPEC_GET(DT_NODELABEL(mcp3201_ch0), SPI_OP, 0),
-	.ch_num = ADC_CH0,
-	.laston = -1,
-	.runtime = 0,
-	.total_unreported = 0,
-	.total_cloud = 0,
-	.loaded_from_cloud = false
+#define DT_DRV_COMPAT microchip_mcp3201
+
+static const char ch_keys[ADC_MAX_CHANNELS][sizeof("chN")] = {
+	"ch0", "ch1", "ch2", "ch3", "ch4", "ch5", "ch6", "ch7",
 };
 
-adc_node_t adc_ch1 = {
-	.spi = SPI_DT_SPEC_GET(DT_NODELABEL(mcp3201_ch1), SPI_OP, 0),
-	.ch_num = ADC_CH1,
-	.laston = -1,
-	.runtime = 0,
-	.total_unreported = 0,
-	.total_cloud = 0,
-	.loaded_from_cloud = false
+static const char ch_energy_keys[ADC_MAX_CHANNELS][sizeof("chN_mwh")] = {
+	"ch0_mwh", "ch1_mwh", "ch2_mwh", "ch3_mwh", "ch4_mwh", "ch5_mwh", "ch6_mwh", "ch7_mwh",
 };
 
-/* Store two values for each ADC reading */
-struct mcp3201_data {
-	uint16_t val1;
-	uint16_t val2;
+/*
+ * One channel per enabled microchip,mcp3201 node. The chip select index in
+ * its reg property is the channel number, so every array below is indexed
+ * the same way whatever order the instances are numbered in.
+ */
+#define ADC_CH(inst) DT_INST_REG_ADDR(inst)
+
+#define ADC_NODE_INIT(inst)                                                                        \
+	[ADC_CH(inst)] = {                                                                         \
+		.spi = SPI_DT_SPEC_INST_GET(inst, SPI_OP, 0),                                      \
+		.ch_num = ADC_CH(inst),                                                            \
+		.key = ch_keys[ADC_CH(inst)],                                                      \
+		.energy_key = ch_energy_keys[ADC_CH(inst)],                                        \
+		.fsm.edge_ms = -1,                                                                 \
+	},
+
+#define ADC_CH_BIT(inst) | BIT(ADC_CH(inst))
+
+static adc_node_t adc_nodes[] = { DT_INST_FOREACH_STATUS_OKAY(ADC_NODE_INIT) };
+
+/* Every channel from 0 to ADC_NUM_CHANNELS - 1 is used exactly once */
+BUILD_ASSERT(ARRAY_SIZE(adc_nodes) == ADC_NUM_CHANNELS,
+	     "microchip,mcp3201 reg values must be 0 to the number of channels - 1");
+BUILD_ASSERT((0 DT_INST_FOREACH_STATUS_OKAY(ADC_CH_BIT)) == BIT_MASK(ADC_NUM_CHANNELS),
+	     "microchip,mcp3201 reg values must be unique");
+
+#define SAMPLE_PERIOD_US  (USEC_PER_SEC / CONFIG_APP_SAMPLE_RATE_HZ)
+#define SAMPLE_INDEX_MASK (CONFIG_APP_SAMPLE_BUFFER_LEN - 1)
+
+/* Fractional bits of the RMS value in raw ADC counts */
+#define RMS_FRAC_BITS 8
+
+static void sampling_thread(void *p1, void *p2, void *p3);
+
+K_TIMER_DEFINE(sample_timer, NULL, NULL);
+K_THREAD_DEFINE(sampling_tid, CONFIG_APP_SAMPLING_THREAD_STACK_SIZE, sampling_thread, NULL, NULL,
+		NULL, CONFIG_APP_SAMPLING_THREAD_PRIORITY, 0, SYS_FOREVER_MS);
+
+const char *app_sensors_ch_key(uint8_t ch_num)
+{
+	return (ch_num < ARRAY_SIZE(adc_nodes)) ? adc_nodes[ch_num].key : "";
+}
+
+const char *app_sensors_ch_energy_key(uint8_t ch_num)
+{
+	return (ch_num < ARRAY_SIZE(adc_nodes)) ? adc_nodes[ch_num].energy_key : "";
+}
+
+/*
+ * Seqlock reader. The sampling thread is cooperative and never blocks while
+ * writing a snapshot, so a preemptible reader cannot observe a write in
+ * progress and the loop completes on its first pass.
+ */
+void app_sensors_get_snapshot(uint8_t ch_num, struct adc_snapshot *snap)
+{
+	const adc_node_t *ch = &adc_nodes[ch_num];
+	atomic_val_t seq;
+
+	do {
+		seq = atomic_get(&ch->snap_seq);
+		barrier_dmem_fence_full();
+		*snap = ch->snap;
+		barrier_dmem_fence_full();
+	} while ((seq & 1) || (seq != atomic_get(&ch->snap_seq)));
+}
+
+/* Seqlock writer, only called from the sampling thread */
+static void publish_snapshot(adc_node_t *ch, uint32_t rms_ua)
+{
+	const struct onoff_fsm *fsm = &ch->fsm;
+
+	atomic_inc(&ch->snap_seq);
+	barrier_dmem_fence_full();
+
+	ch->snap.rms_ua = rms_ua;
+	ch->snap.on = fsm->on;
+	ch->snap.loaded = fsm->base_set;
+	ch->snap.reconciled = fsm->reconciled;
+	ch->snap.runtime_ms = fsm->runtime_ms;
+	ch->snap.cumulative_ms = fsm->base_ms + fsm->total_ms;
+	ch->snap.cumulative_mwh = fsm->base_mwh + fsm->total_mwh;
+
+	barrier_dmem_fence_full();
+	atomic_inc(&ch->snap_seq);
+}
+
+/*
+ * Changes to the cumulative values are made by the sampling thread, which
+ * owns the totals. Other threads post them here.
+ */
+enum totals_op {
+	TOTALS_RESET,
+	/* Restored from flash or loaded from the cloud, used if nothing is yet */
+	TOTALS_LOAD,
+	/* Cloud value newer than the flash checkpoint */
+	TOTALS_OVERRIDE,
+	/* Cloud value from the same checkpoint, keep the larger per channel */
+	TOTALS_MAX,
 };
 
-int get_ontime(struct ontime *ot)
+struct totals_msg {
+	enum totals_op op;
+	/* Read from state/cumulative */
+	bool from_cloud;
+	uint64_t ms[ADC_NUM_CHANNELS];
+	uint64_t mwh[ADC_NUM_CHANNELS];
+};
+
+K_MSGQ_DEFINE(totals_msgq, sizeof(struct totals_msg), 4, 8);
+
+/* state/cumulative has been read since boot */
+static atomic_t cumulative_checked;
+
+static void apply_totals_msg(const struct totals_msg *msg)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		struct onoff_fsm *fsm = &adc_nodes[i].fsm;
+
+		if (msg->op == TOTALS_RESET) {
+			fsm->base_ms = -(int64_t)fsm->total_ms;
+			fsm->base_mwh = -(int64_t)fsm->total_mwh;
+		} else if ((msg->op == TOTALS_MAX) && fsm->base_set) {
+			/* Reports made after the last checkpoint carry its
+			 * sequence number with larger totals
+			 */
+			fsm->base_ms = MAX(fsm->base_ms, (int64_t)msg->ms[i]);
+			fsm->base_mwh = MAX(fsm->base_mwh, (int64_t)msg->mwh[i]);
+		} else if ((msg->op == TOTALS_OVERRIDE) || !fsm->base_set) {
+			/* The device is the only writer of state/cumulative, so
+			 * once the base is set later loads carry nothing new
+			 * unless flash lost a checkpoint. ON time since boot is
+			 * added on top of the loaded value.
+			 */
+			fsm->base_ms = msg->ms[i];
+			fsm->base_mwh = msg->mwh[i];
+		}
+
+		fsm->base_set = true;
+		fsm->reconciled = fsm->reconciled || msg->from_cloud;
+	}
+
+	/* Runs once the snapshots published after this window are current */
+	app_totals_request_checkpoint();
+}
+
+static int post_totals_msg(const struct totals_msg *msg)
 {
-	if (k_sem_take(&adc_data_sem, K_MSEC(300)) == 0) {
-		ot->ch0 = adc_ch0.runtime;
-		ot->ch1 = adc_ch1.runtime;
-		k_sem_give(&adc_data_sem);
+	int err = k_msgq_put(&totals_msgq, msg, K_NO_WAIT);
+
+	if (err) {
+		LOG_ERR("Cumulative update queue full: %d", err);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+	uint64_t res = 0;
+	uint64_t bit = 1ULL << 62;
+
+	while (bit > v) {
+		bit >>= 2;
+	}
+
+	while (bit) {
+		if (v >= res + bit) {
+			v -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint32_t)res;
+}
+
+static inline void rms_acc_add(struct rms_acc *acc, uint16_t sample)
+{
+	acc->sum += sample;
+	acc->sum_sq += (uint32_t)sample * sample;
+	acc->count++;
+}
+
+/*
+ * Return the RMS of the window with the DC offset (window mean) removed, in
+ * raw ADC counts with RMS_FRAC_BITS fractional bits, and reset the window.
+ *
+ * n^2 * variance = n * sum(x^2) - sum(x)^2 is exact in 64-bit integers for
+ * 12-bit samples and windows of up to several thousand samples.
+ */
+
+/* Most samples a window can hold, the timer may run slightly fast */
+#define RMS_WINDOW_MAX_SAMPLES                                                                     \
+	((((uint64_t)CONFIG_APP_RMS_CYCLES * USEC_PER_SEC) /                                       \
+	  ((uint64_t)CONFIG_APP_MAINS_FREQ_HZ * SAMPLE_PERIOD_US)) + 1)
+
+/* The variance of 12-bit samples is below 2^22, so n^2 * variance with
+ * 2 * RMS_FRAC_BITS fractional bits fits 64 bits for up to 2^13 samples
+ */
+#define RMS_WINDOW_LIMIT BIT64((64 - 22 - (2 * RMS_FRAC_BITS)) / 2)
+
+BUILD_ASSERT(RMS_WINDOW_MAX_SAMPLES <= RMS_WINDOW_LIMIT,
+	     "RMS window too long: lower CONFIG_APP_SAMPLE_RATE_HZ or CONFIG_APP_RMS_CYCLES");
+
+static uint32_t rms_acc_finish(struct rms_acc *acc)
+{
+	uint64_t n = acc->count;
+	uint64_t var_n2;
+	uint32_t rms_q;
+
+	if (n == 0) {
 		return 0;
 	}
 
-	return -ENOLCK;
+	var_n2 = (n * acc->sum_sq) - ((uint64_t)acc->sum * acc->sum);
+	rms_q = isqrt64(var_n2 << (2 * RMS_FRAC_BITS)) / n;
+
+	*acc = (struct rms_acc){0};
+
+	return rms_q;
 }
 
-/* Callback for LightDB Stream */
-static void async_error_handler(struct golioth_client *client, enum golioth_status status,
-				const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
-				void *arg)
+static uint32_t rms_q_to_ua(uint32_t rms_q)
 {
-	if (status != GOLIOTH_OK) {
-		LOG_ERR("Async task failed: %d", status);
+	return (((uint64_t)rms_q * ADC_RAW_TO_NANOAMP) >> RMS_FRAC_BITS) / 1000;
+}
+
+/* The sketch resolves 1/16 of a raw count, well below one ADC step */
+#define AGG_SKETCH_SHIFT (RMS_FRAC_BITS - 4)
+#define AGG_SKETCH_SUB	 BIT(AGG_SKETCH_SUB_BITS)
+
+BUILD_ASSERT((4096 << (RMS_FRAC_BITS - AGG_SKETCH_SHIFT)) <= BIT(AGG_SKETCH_VALUE_BITS),
+	     "Percentile sketch does not cover the ADC range");
+
+/* Index of the agg_acc the sampling thread is filling */
+static atomic_t agg_active;
+
+/*
+ * Log-linear bucket of an RMS level. A bucket is never wider than
+ * 1 / AGG_SKETCH_SUB of its lower bound, so reporting its midpoint is
+ * within 6.25 % of any level in it.
+ */
+static uint32_t agg_bucket(uint32_t rms_q)
+{
+	uint32_t v = MIN(rms_q >> AGG_SKETCH_SHIFT, BIT(AGG_SKETCH_VALUE_BITS) - 1);
+	uint32_t exp;
+
+	if (v < AGG_SKETCH_SUB) {
+		return v;
+	}
+
+	exp = 31 - __builtin_clz(v);
+
+	return ((exp - AGG_SKETCH_SUB_BITS + 1) << AGG_SKETCH_SUB_BITS) +
+	       ((v >> (exp - AGG_SKETCH_SUB_BITS)) & (AGG_SKETCH_SUB - 1));
+}
+
+static uint32_t agg_bucket_mid_q(uint32_t bucket)
+{
+	uint32_t shift = 0;
+	uint32_t lower = bucket;
+
+	if (bucket >= AGG_SKETCH_SUB) {
+		shift = (bucket >> AGG_SKETCH_SUB_BITS) - 1;
+		lower = (AGG_SKETCH_SUB + (bucket & (AGG_SKETCH_SUB - 1))) << shift;
+	}
+
+	return ((2 * lower + BIT(shift)) << AGG_SKETCH_SHIFT) / 2;
+}
+
+/* Only called from the sampling thread */
+static void agg_add(struct agg_acc *acc, uint32_t rms_q)
+{
+	if ((acc->count == 0) || (rms_q < acc->min_q)) {
+		acc->min_q = rms_q;
+	}
+	if ((acc->count == 0) || (rms_q > acc->max_q)) {
+		acc->max_q = rms_q;
+	}
+
+	acc->count++;
+	acc->sum_q += rms_q;
+	acc->sum_sq_q += (uint64_t)rms_q * rms_q;
+	acc->sketch[agg_bucket(rms_q)]++;
+}
+
+/* Nearest-rank percentile, clamped to the levels actually seen */
+static uint32_t agg_percentile_q(const struct agg_acc *acc, uint32_t pct)
+{
+	uint32_t rank = DIV_ROUND_UP((uint64_t)acc->count * pct, 100);
+	uint32_t seen = 0;
+
+	for (uint32_t i = 0; i < AGG_SKETCH_BUCKETS; i++) {
+		seen += acc->sketch[i];
+		if (seen >= rank) {
+			return CLAMP(agg_bucket_mid_q(i), acc->min_q, acc->max_q);
+		}
+	}
+
+	return acc->max_q;
+}
+
+static void agg_finish(const struct agg_acc *acc, struct ch_agg *agg)
+{
+	if (acc->count == 0) {
+		*agg = (struct ch_agg){0};
 		return;
 	}
+
+	agg->min_ua = rms_q_to_ua(acc->min_q);
+	agg->max_ua = rms_q_to_ua(acc->max_q);
+	agg->mean_ua = rms_q_to_ua(acc->sum_q / acc->count);
+	agg->rms_ua = rms_q_to_ua(isqrt64(acc->sum_sq_q / acc->count));
+	agg->p95_ua = rms_q_to_ua(agg_percentile_q(acc, 95));
+	agg->p99_ua = rms_q_to_ua(agg_percentile_q(acc, 99));
 }
 
 /*
- * Validate data received from MCP3201
+ * Switch the sampling thread to the other buffer and summarise the windows
+ * since the previous record. The sampling thread is cooperative, so it is
+ * never part way through a window when this runs.
  */
-static int process_adc_reading(uint8_t buf_data[4], struct mcp3201_data *adc_data)
+static void roll_aggregates(struct sensor_record *rec)
 {
-	if (buf_data[0] & 1<<5) {	/* Missing NULL bit */
-		return -ENOTSUP;
+	atomic_val_t idx = atomic_xor(&agg_active, 1);
+
+	rec->agg_count = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		struct agg_acc *acc = &adc_nodes[i].agg[idx];
+
+		rec->agg_count = acc->count;
+		agg_finish(acc, &rec->agg[i]);
+		memset(acc, 0, sizeof(*acc));
 	}
+}
 
-	uint16_t data_msb = 0;
-	uint16_t data_lsb = 0;
+/*
+ * Raw frames for every channel. The sampling thread clocks one set in while
+ * it decodes the set captured on the previous sample period.
+ */
+struct adc_frame_set {
+	uint8_t raw[ADC_NUM_CHANNELS][4];
+	bool valid[ADC_NUM_CHANNELS];
+	struct spi_buf buf[ADC_NUM_CHANNELS];
+	struct spi_buf_set set[ADC_NUM_CHANNELS];
+};
 
-	data_msb = buf_data[0] & 0x1F;
-	data_msb |= (data_msb << 7) | (buf_data[1] >> 1);
+static struct adc_frame_set frame_sets[2];
 
-	for (uint8_t i = 0; i < 12; i++) {
-		bool bit_set = false;
+/* Acquisition statistics, reset when read by the main loop */
+static atomic_t acq_periods;
+static atomic_t acq_missed;
+static int64_t acq_stats_since;
 
-		if (i < 2) {
-			if (buf_data[1] & (1 << (1 - i))) {
-				bit_set = true;
-			}
-		} else if (i < 10) {
-			if (buf_data[2] & (1 << (2 + 7 - i))) {
-				bit_set = true;
-			}
-		} else {
-			if (buf_data[3] & (1 << (10 + 7 - i))) {
-				bit_set = true;
-			}
-		}
-		if (bit_set) {
-			data_lsb |= (1 << i);
+#ifdef CONFIG_APP_LOW_POWER
+/* Windows in a burst, plus a second for the SPI resume and scheduling */
+#define BURST_TIMEOUT                                                                              \
+	K_MSEC(((CONFIG_APP_LOW_POWER_BURST_WINDOWS * CONFIG_APP_RMS_CYCLES * MSEC_PER_SEC) /     \
+		CONFIG_APP_MAINS_FREQ_HZ) + MSEC_PER_SEC)
+
+static K_SEM_DEFINE(burst_start, 0, 1);
+static K_SEM_DEFINE(burst_done, 0, 1);
+
+/* Time spent in bursts since the acquisition statistics were last read */
+static atomic_t acq_active_ms;
+#endif
+
+#ifdef CONFIG_SPI_ASYNC
+#define SPI_DONE_TIMEOUT K_MSEC(10)
+
+static K_SEM_DEFINE(spi_done, 0, 1);
+static int spi_done_result;
+/* A transfer timed out and may still write into its frame buffer */
+static atomic_t spi_late;
+
+static void spi_done_cb(const struct device *dev, int result, void *data)
+{
+	/* Nobody waits for a transfer that already timed out */
+	if (atomic_cas(&spi_late, 1, 0)) {
+		return;
+	}
+
+	spi_done_result = result;
+	k_sem_give(&spi_done);
+}
+#endif
+
+static void frame_sets_init(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(frame_sets); i++) {
+		struct adc_frame_set *fs = &frame_sets[i];
+
+		/* Buffer descriptors must outlive an asynchronous transfer */
+		for (size_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+			fs->buf[ch].buf = fs->raw[ch];
+			fs->buf[ch].len = sizeof(fs->raw[ch]);
+			fs->set[ch].buffers = &fs->buf[ch];
+			fs->set[ch].count = 1;
 		}
 	}
+}
+
+/* Clock in one frame. With CONFIG_SPI_ASYNC this returns once the transfer
+ * is started and adc_read_wait() blocks until the completion callback.
+ */
+static int adc_read_start(adc_node_t *adc, struct adc_frame_set *fs)
+{
+	const struct spi_buf_set *rx = &fs->set[adc->ch_num];
+
+#ifdef CONFIG_SPI_ASYNC
+	/* Frames are skipped until the late transfer completes */
+	if (atomic_get(&spi_late)) {
+		return -EBUSY;
+	}
+
+	k_sem_reset(&spi_done);
+
+	return spi_transceive_cb(adc->spi.bus, &adc->spi.config, NULL, rx, spi_done_cb, NULL);
+#else
+	return spi_read_dt(&(adc->spi), rx);
+#endif
+}
 
-	adc_data->val1 = data_msb;
-	adc_data->val2 = data_lsb;
+static int adc_read_wait(void)
+{
+#ifdef CONFIG_SPI_ASYNC
+	if (k_sem_take(&spi_done, SPI_DONE_TIMEOUT)) {
+		/* The caller marks the frame invalid, and the callback clears
+		 * the flag once the transfer is really over
+		 */
+		atomic_set(&spi_late, 1);
+
+		/* Completed between the timeout and setting the flag */
+		if (k_sem_take(&spi_done, K_NO_WAIT) == 0) {
+			atomic_set(&spi_late, 0);
+		}
+
+		return -ETIMEDOUT;
+	}
 
+	return spi_done_result;
+#else
 	return 0;
+#endif
+}
+
+static void adc_process_frame(adc_node_t *adc, const struct adc_frame_set *fs)
+{
+	struct mcp3201_data adc_data;
+	uint32_t idx;
+
+	/* This runs at the sample rate: count failures instead of logging them */
+	if (!fs->valid[adc->ch_num] || mcp3201_decode(fs->raw[adc->ch_num], &adc_data)) {
+		atomic_inc(&adc->read_errors);
+		app_metrics_inc(METRICS_SPI_ERRORS);
+		return;
+	}
+
+	idx = (uint32_t)atomic_get(&adc->sample_count);
+	adc->samples[idx & SAMPLE_INDEX_MASK] = adc_data.val1;
+	atomic_inc(&adc->sample_count);
+	rms_acc_add(&adc->rms, adc_data.val1);
+}
+
+void app_sensors_get_acq_stats(struct acq_stats *stats)
+{
+	int64_t now = k_uptime_get();
+	int64_t elapsed = now - acq_stats_since;
+	uint32_t periods = (uint32_t)atomic_clear(&acq_periods);
+
+#ifdef CONFIG_APP_LOW_POWER
+	/* The rate achieved while sampling, not averaged over the idle time */
+	elapsed = atomic_clear(&acq_active_ms);
+#endif
+
+	stats->missed = (uint32_t)atomic_clear(&acq_missed);
+	stats->rate_hz = (elapsed > 0) ? ((uint64_t)periods * MSEC_PER_SEC) / elapsed : 0;
+	acq_stats_since = now;
+}
+
+int app_sensors_get_samples(uint8_t ch_num, uint16_t *dst, size_t count)
+{
+	adc_node_t *adc;
+	uint32_t start;
+	uint32_t end;
+
+	if ((ch_num >= ARRAY_SIZE(adc_nodes)) || (count > CONFIG_APP_SAMPLE_BUFFER_LEN)) {
+		return -EINVAL;
+	}
+
+	adc = &adc_nodes[ch_num];
+	end = (uint32_t)atomic_get(&adc->sample_count);
+	if (end < count) {
+		return -EAGAIN;
+	}
+
+	start = end - count;
+	for (size_t i = 0; i < count; i++) {
+		dst[i] = adc->samples[(start + i) & SAMPLE_INDEX_MASK];
+	}
+
+	/* The sampling thread may have lapped us while copying */
+	if (((uint32_t)atomic_get(&adc->sample_count) - start) > CONFIG_APP_SAMPLE_BUFFER_LEN) {
+		return -EAGAIN;
+	}
+
+	return count;
+}
+
+/* Samples taken on a channel since boot, wrapping at 2^32 */
+uint32_t app_sensors_sample_count(uint8_t ch_num)
+{
+	return (uint32_t)atomic_get(&adc_nodes[ch_num].sample_count);
 }
 
-static int get_adc_reading(adc_node_t *adc, struct mcp3201_data *adc_data)
+static int push_adc_to_golioth(struct sensor_record *rec)
 {
+	enum deadband_result result = app_deadband_check(rec);
 	int err;
-	static uint8_t my_buffer[4] = {0};
-	struct spi_buf my_spi_buffer[1];
 
-	my_spi_buffer[0].buf = my_buffer;
-	my_spi_buffer[0].len = 4;
-	const struct spi_buf_set rx_buff = { my_spi_buffer, 1 };
+	/* A suppressed record leaves the aggregates running, so the next one
+	 * sent covers all the time since the previous record.
+	 */
+	if (result != DEADBAND_SUPPRESS) {
+		roll_aggregates(rec);
+		app_batch_add(rec);
+	}
 
-	err = spi_read_dt(&(adc->spi), &rx_buff);
-	if (err) {
-		LOG_INF("spi_read status: %d", err);
-		return err;
+	/* Hold records until the batch is full or old enough so the modem is
+	 * only woken once per batch, unless the current actually changed or a
+	 * new record can go out while the radio is connected anyway.
+	 */
+	if ((result != DEADBAND_CHANGED) && !app_batch_ready() &&
+	    !((result != DEADBAND_SUPPRESS) && app_power_modem_active())) {
+		return 0;
 	}
-	LOG_DBG("Received 4 bytes: %d %d %d %d", my_buffer[0], my_buffer[1], my_buffer[2], my_buffer[3]);
 
-	err = process_adc_reading(my_buffer, adc_data);
+	/* Streams the batch if connected, otherwise stores it in flash */
+	err = app_batch_flush();
 	if (err) {
-		LOG_ERR("Failed to process ADC readings %d", err);
 		return err;
 	}
 
-	LOG_INF("mcp3201_ch%d received two ADC readings: 0x%04x\t0x%04x",
-		adc->ch_num, adc_data->val1, adc_data->val2);
+	if (golioth_client_is_connected(client)) {
+		app_state_report_ontime();
+	}
 
 	return 0;
 }
 
-static int push_adc_to_golioth(uint16_t ch0_data, uint16_t ch1_data)
+static void onoff_commit(struct onoff_fsm *fsm, int64_t until)
 {
-	int err;
-	char json_buf[128];
+	if (until > fsm->committed_ms) {
+		fsm->runtime_ms += until - fsm->committed_ms;
+		fsm->total_ms += until - fsm->committed_ms;
+		fsm->committed_ms = until;
+	}
+}
 
-	snprintk(json_buf, sizeof(json_buf), JSON_FMT, ch0_data, ch1_data);
+/*
+ * Advance the ON/OFF state machine by one RMS window spanning
+ * [win_start, now].
+ *
+ * The smoothed level must rise above floor + hysteresis to turn ON and fall
+ * to the floor or below to turn OFF, and must stay there for the dwell
+ * time. Transitions are timestamped where the condition started. ON time
+ * is held back while an OFF transition is pending, so a confirmed OFF does
+ * not count the dwell period as running.
+ */
+static void onoff_update(adc_node_t *ch, uint32_t rms_q, int64_t win_start, int64_t now)
+{
+	struct onoff_fsm *fsm = &ch->fsm;
+	uint32_t off_q = (uint32_t)get_adc_floor(ch->ch_num) << RMS_FRAC_BITS;
+	uint32_t on_q = off_q + ((uint32_t)get_adc_hysteresis() << RMS_FRAC_BITS);
 
-	/* Only stream sensor data if connected */
-	if (golioth_client_is_connected(client)) {
-		err = golioth_stream_set_async(client,
-					ADC_STREAM_ENDP,
-					GOLIOTH_CONTENT_TYPE_JSON,
-					json_buf,
-					strlen(json_buf),
-					async_error_handler,
-					NULL);
-		if (err) {
-			LOG_ERR("Failed to send sensor data to Golioth: %d", err);
-			return err;
+	fsm->smooth_q += ((int32_t)rms_q - (int32_t)fsm->smooth_q) >>
+			 CONFIG_APP_ONOFF_SMOOTHING_SHIFT;
+
+	if (!fsm->on) {
+		if (fsm->smooth_q <= on_q) {
+			fsm->edge_ms = -1;
+			return;
+		}
+
+		if (fsm->edge_ms < 0) {
+			fsm->edge_ms = win_start;
+		}
+
+		if ((now - fsm->edge_ms) < get_on_dwell_ms()) {
+			return;
 		}
 
-		app_state_report_ontime(&adc_ch0, &adc_ch1);
+		fsm->on = true;
+		fsm->runtime_ms = 0;
+		fsm->committed_ms = fsm->edge_ms;
+		app_events_push(ch->ch_num, true, fsm->edge_ms);
+		fsm->edge_ms = -1;
+	} else if (fsm->smooth_q <= off_q) {
+		if (fsm->edge_ms < 0) {
+			fsm->edge_ms = win_start;
+		}
+
+		if ((now - fsm->edge_ms) < get_off_dwell_ms()) {
+			return;
+		}
+
+		onoff_commit(fsm, fsm->edge_ms);
+		fsm->on = false;
+		fsm->runtime_ms = 0;
+		app_events_push(ch->ch_num, false, fsm->edge_ms);
+		fsm->edge_ms = -1;
+		return;
+	} else {
+		fsm->edge_ms = -1;
 	}
 
-	return 0;
+	onoff_commit(fsm, now);
 }
 
-static void update_ontime(uint16_t adc_value, adc_node_t *ch)
+/* uA * V * PF% * ms in one mWh: 1e6 uA/A * 100 % * 3.6e6 ms/h / 1e3 mW/W */
+#define ENERGY_FRAC_PER_MWH 360000000000ULL
+
+/*
+ * Integrate P = I_rms * V * PF over one window while the channel is ON. The
+ * remainder below 1 mWh is carried over, so nothing is lost to rounding
+ * however short the window.
+ */
+static void energy_update(struct onoff_fsm *fsm, uint32_t rms_ua, int64_t dt_ms)
 {
-	if (k_sem_take(&adc_data_sem, K_MSEC(300)) == 0) {
-		if (adc_value <= get_adc_floor(ch->ch_num)) {
-			ch->runtime = 0;
-			ch->laston = -1;
-		} else {
-			int64_t ts = k_uptime_get();
-			int64_t duration;
+	uint64_t power = (uint64_t)rms_ua * get_line_voltage() * get_power_factor_pct();
+	uint64_t max_step_ms;
 
-			if (ch->laston > 0) {
-				duration = ts - ch->laston;
-			} else {
-				duration = 1;
-			}
-			ch->runtime += duration;
-			ch->laston = ts;
-			ch->total_unreported += duration;
-		}
-		k_sem_give(&adc_data_sem);
+	if (!fsm->on || (dt_ms <= 0) || (power == 0)) {
 		return;
 	}
 
-	LOG_ERR("Failed to update ontime for ch%d: semaphore unavailable", ch->ch_num);
+	/* Low-power gaps last up to LOOP_DELAY_S_MAX, and power * dt_ms can
+	 * then overflow, so long spans are added in steps that fit
+	 */
+	max_step_ms = (UINT64_MAX - ENERGY_FRAC_PER_MWH) / power;
+
+	while (dt_ms > 0) {
+		uint64_t step_ms = MIN((uint64_t)dt_ms, max_step_ms);
+
+		fsm->energy_frac += power * step_ms;
+		fsm->total_mwh += fsm->energy_frac / ENERGY_FRAC_PER_MWH;
+		fsm->energy_frac %= ENERGY_FRAC_PER_MWH;
+		dt_ms -= step_ms;
+	}
 }
 
-int reset_cumulative_totals(void)
+static void update_ontime(adc_node_t *ch, uint32_t rms_q, int64_t win_start, int64_t now)
 {
-	if (k_sem_take(&adc_data_sem, K_MSEC(5000)) == 0) {
-		adc_ch0.total_cloud = 0;
-		adc_ch1.total_cloud = 0;
-		adc_ch0.total_unreported = 0;
-		adc_ch1.total_unreported = 0;
-		k_sem_give(&adc_data_sem);
+	uint32_t rms_ua = rms_q_to_ua(rms_q);
 
-		return 0;
+	onoff_update(ch, rms_q, win_start, now);
+	energy_update(&ch->fsm, rms_ua, now - win_start);
+	publish_snapshot(ch, rms_ua);
+}
+
+uint32_t app_sensors_sample_rate_mhz(void)
+{
+	uint64_t period_ticks = k_us_to_ticks_ceil32(SAMPLE_PERIOD_US);
+
+	return ((uint64_t)CONFIG_SYS_CLOCK_TICKS_PER_SEC * MSEC_PER_SEC) / period_ticks;
+}
+
+/*
+ * Number of samples spanning CONFIG_APP_RMS_CYCLES mains cycles at the rate
+ * the sample timer actually achieves after rounding the period to ticks.
+ */
+static uint32_t samples_per_rms_window(void)
+{
+	uint64_t period_ticks = k_us_to_ticks_ceil32(SAMPLE_PERIOD_US);
+	uint64_t num = (uint64_t)CONFIG_APP_RMS_CYCLES * CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	uint64_t den = (uint64_t)CONFIG_APP_MAINS_FREQ_HZ * period_ticks;
+
+	return MAX(1, (num + (den / 2)) / den);
+}
+
+#ifdef CONFIG_APP_LOW_POWER
+static void spi_buses_action(enum pm_device_action action)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		/* Channels usually share a bus, which only changes state once */
+		int err = pm_device_action_run(adc_nodes[i].spi.bus, action);
+
+		if (err && (err != -EALREADY)) {
+			LOG_WRN("SPI power action %d failed: %d", action, err);
+		}
+	}
+}
+
+/*
+ * Run one sampling burst from the main loop. The chip selects are released
+ * between bursts, which leaves the MCP3201s in standby, and the SPI bus is
+ * suspended.
+ */
+static void run_burst(void)
+{
+	int64_t start;
+	int64_t elapsed;
+
+	/* Keep acquisition clear of the radio's transmit current */
+	if (app_power_wait_modem_idle(K_SECONDS(CONFIG_APP_LOW_POWER_MODEM_WAIT_S))) {
+		LOG_DBG("Radio still connected, sampling anyway");
+	}
+
+	start = k_uptime_get();
+	spi_buses_action(PM_DEVICE_ACTION_RESUME);
+
+	k_sem_give(&burst_start);
+	if (k_sem_take(&burst_done, BURST_TIMEOUT)) {
+		/* Never suspend the bus under a running burst */
+		APP_LOG_WRN_RATELIMIT("Sampling burst overran");
+		k_sem_take(&burst_done, K_FOREVER);
 	}
 
-	LOG_ERR("Could not reset cumulative values; blocked by semaphore.");
+	spi_buses_action(PM_DEVICE_ACTION_SUSPEND);
 
-	return -EACCES;
+	elapsed = k_uptime_get() - start;
+	atomic_add(&acq_active_ms, elapsed);
+	app_power_add_acq_ms(elapsed);
 }
 
+/* Park the sampling thread with the timer stopped until the next burst */
+static void burst_wait(void)
+{
+	k_timer_stop(&sample_timer);
+	k_sem_give(&burst_done);
+	k_sem_take(&burst_start, K_FOREVER);
+	k_timer_start(&sample_timer, K_USEC(SAMPLE_PERIOD_US), K_USEC(SAMPLE_PERIOD_US));
+}
+#endif /* CONFIG_APP_LOW_POWER */
+
+static void sampling_thread(void *p1, void *p2, void *p3)
+{
+	uint32_t window_len = samples_per_rms_window();
+	uint32_t window_samples = 0;
+	uint8_t cur = 0;
+	bool primed = false;
+	int64_t win_start;
+#ifdef CONFIG_APP_LOW_POWER
+	uint32_t burst_windows = 0;
+#endif
+
+	LOG_INF("RMS window: %u samples over %d mains cycles", window_len, CONFIG_APP_RMS_CYCLES);
+
+	frame_sets_init();
+	IF_ENABLED(CONFIG_APP_LOW_POWER, (k_sem_take(&burst_start, K_FOREVER);));
+	acq_stats_since = k_uptime_get();
+	win_start = acq_stats_since;
+
+	k_timer_start(&sample_timer, K_USEC(SAMPLE_PERIOD_US), K_USEC(SAMPLE_PERIOD_US));
+
+	while (true) {
+		struct adc_frame_set *fs = &frame_sets[cur];
+		struct adc_frame_set *prev = &frame_sets[cur ^ 1];
+		uint32_t expired = k_timer_status_sync(&sample_timer);
+		uint32_t t_acq = app_metrics_now();
+
+		if (expired > 1) {
+			atomic_add(&acq_missed, expired - 1);
+			app_metrics_add(METRICS_ACQ_MISSED, expired - 1);
+		}
+
+		/* Service the chip selects back to back. While a transfer is in
+		 * flight, decode the frame read for that channel last period.
+		 */
+		for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+			adc_node_t *adc = &adc_nodes[i];
+			uint64_t t_spi = app_bench_start();
+			int err = adc_read_start(adc, fs);
+			uint64_t t_decode = app_bench_start();
+
+			if (primed) {
+				adc_process_frame(adc, prev);
+				app_bench_stop(BENCH_DECODE, t_decode);
+			}
+
+			/* The decode overlaps the transfer and is not counted in it */
+			t_spi += app_bench_start() - t_decode;
+			if (err == 0) {
+				uint32_t t_wait = app_metrics_now();
+
+				err = adc_read_wait();
+				app_metrics_record(METRICS_SPI_WAIT, t_wait);
+			}
+			app_bench_stop(BENCH_SPI, t_spi);
+			fs->valid[adc->ch_num] = (err == 0);
+
+			if (err == -ETIMEDOUT) {
+				app_metrics_inc(METRICS_SPI_TIMEOUTS);
+			}
+		}
+
+		app_metrics_record(METRICS_ACQ, t_acq);
+		cur ^= 1;
+		atomic_inc(&acq_periods);
+		app_capture_poll();
+
+		if (!primed) {
+			primed = true;
+			continue;
+		}
+
+		if (++window_samples < window_len) {
+			continue;
+		}
+		window_samples = 0;
+
+		/* Apply resets and cloud totals posted since the last window */
+		struct totals_msg msg;
+
+		while (k_msgq_get(&totals_msgq, &msg, K_NO_WAIT) == 0) {
+			apply_totals_msg(&msg);
+		}
+
+		/* Run the ON/OFF detection on the RMS level of each channel */
+		int64_t now = k_uptime_get();
+		atomic_val_t agg_idx = atomic_get(&agg_active);
+
+		for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+			adc_node_t *adc = &adc_nodes[i];
+			uint32_t rms_q = rms_acc_finish(&adc->rms);
+
+			uint64_t t_window = app_bench_start();
+
+			agg_add(&adc->agg[agg_idx], rms_q);
+			update_ontime(adc, rms_q, win_start, now);
+			app_bench_stop(BENCH_WINDOW, t_window);
+			app_capture_window(adc->ch_num, adc->snap.rms_ua);
+		}
+		win_start = now;
+
+#ifdef CONFIG_APP_LOW_POWER
+		if (++burst_windows >= CONFIG_APP_LOW_POWER_BURST_WINDOWS) {
+			/* win_start is left alone, so the first window of the next
+			 * burst spans the gap: ON time and energy in between are
+			 * extrapolated from it.
+			 */
+			burst_windows = 0;
+			burst_wait();
+
+			/* Frames read before the gap are stale */
+			primed = false;
+		}
+#endif
+	}
+}
+
+int reset_cumulative_totals(void)
+{
+	struct totals_msg msg = {
+		.op = TOTALS_RESET,
+	};
+
+	return post_totals_msg(&msg);
+}
+
+int load_cumulative_totals(const uint64_t *ms, const uint64_t *mwh)
+{
+	struct totals_msg msg = {
+		.op = TOTALS_LOAD,
+	};
+
+	memcpy(msg.ms, ms, sizeof(msg.ms));
+	memcpy(msg.mwh, mwh, sizeof(msg.mwh));
+
+	return post_totals_msg(&msg);
+}
+
+/*
+ * Match a state/cumulative key against the channel keys. Returns the channel
+ * number, or -ENOENT for keys that do not belong to a channel. "chN" holds
+ * the on time and "chN_mwh" the energy.
+ */
+static bool key_equals(const struct zcbor_string *key, const char *str)
+{
+	return (key->len == strlen(str)) && (strncmp(key->value, str, key->len) == 0);
+}
+
+static int cumulative_key_to_ch(const struct zcbor_string *key, bool *is_energy)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		if (key_equals(key, adc_nodes[i].key)) {
+			*is_energy = false;
+			return i;
+		}
+
+		if (key_equals(key, adc_nodes[i].energy_key)) {
+			*is_energy = true;
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
 
 static void get_cumulative_handler(struct golioth_client *client, enum golioth_status status,
 				      const struct golioth_coap_rsp_code *coap_rsp_code,
 				      const char *path, const uint8_t *payload, size_t payload_size,
 				      void *arg)
 {
+	struct totals_msg msg = {
+		.op = TOTALS_LOAD,
+		.from_cloud = true,
+	};
+
 	if (status != GOLIOTH_OK) {
 		LOG_ERR("Failed to receive '%s' endpoint: %d", APP_STATE_DESIRED_ENDP, status);
 		return;
@@ -249,22 +977,20 @@ static void get_cumulative_handler(struct golioth_client *client, enum golioth_s
 	if ((payload_size == 1) && (payload[0] == 0xf6)) {
 		/* 0xf6 is `null` in CBOR */
 		LOG_WRN("Cumulative state is null, use runtime as cumulative on next update.");
-		if (k_sem_take(&adc_data_sem, K_MSEC(300)) == 0) {
-			adc_ch0.loaded_from_cloud = true;
-			adc_ch1.loaded_from_cloud = true;
-			k_sem_give(&adc_data_sem);
-		}
+		post_totals_msg(&msg);
+		atomic_set(&cumulative_checked, true);
 		return;
 	}
 
-	uint64_t decoded_ch0 = 0;
-	uint64_t decoded_ch1 = 0;
-	bool found_ch0 = false;
-	bool found_ch1 = false;
+	size_t found = 0;
+	/* Written before sequence numbers were reported counts as the oldest */
+	uint64_t cloud_seq = 0;
 
 	struct zcbor_string key;
 	uint64_t data;
+	bool is_energy;
 	bool ok;
+	int ch;
 
 	ZCBOR_STATE_D(decoding_state, 1, payload, payload_size, 1, NULL);
 	ok = zcbor_map_start_decode(decoding_state);
@@ -279,31 +1005,55 @@ static void get_cumulative_handler(struct golioth_client *client, enum golioth_s
 			goto cumulative_decode_error;
 		}
 
-		if (strncmp(key.value, "ch0", 3) == 0) {
-			found_ch0 = true;
-			decoded_ch0 = data;
-		} else if (strncmp(key.value, "ch1", 3) == 0) {
-			found_ch1 = true;
-			decoded_ch1 = data;
-		} else {
+		if (key_equals(&key, "seq")) {
+			cloud_seq = data;
 			continue;
 		}
+
+		ch = cumulative_key_to_ch(&key, &is_energy);
+		if (ch < 0) {
+			continue;
+		}
+
+		if (is_energy) {
+			msg.mwh[ch] = data;
+		} else {
+			msg.ms[ch] = data;
+			found++;
+		}
 	}
 
-	if ((found_ch0 && found_ch1) == false) {
+	if (found == 0) {
 		goto cumulative_decode_error;
-	} else {
-		LOG_DBG("Decoded: ch0: %lld, ch1: %lld", decoded_ch0, decoded_ch1);
-		if (k_sem_take(&adc_data_sem, K_MSEC(300)) == 0) {
-			adc_ch0.total_cloud = decoded_ch0;
-			adc_ch1.total_cloud = decoded_ch1;
-			adc_ch0.loaded_from_cloud = true;
-			adc_ch1.loaded_from_cloud = true;
-			k_sem_give(&adc_data_sem);
-		}
-		return;
 	}
 
+	/* Channels added since the state was last written start from zero */
+	if (found < ARRAY_SIZE(adc_nodes)) {
+		LOG_WRN("Cumulative state has %zu of %zu channels", found, ARRAY_SIZE(adc_nodes));
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		LOG_DBG("Decoded: %s: %lld, %s: %lld", adc_nodes[i].key, msg.ms[i],
+			adc_nodes[i].energy_key, msg.mwh[i]);
+	}
+
+	/* Reports never carry a sequence number newer than the checkpoint in
+	 * flash, so a newer one means flash was erased or rolled back. Reports
+	 * with the same one were made after the checkpoint and may be ahead.
+	 */
+	if (IS_ENABLED(CONFIG_APP_TOTALS_CHECKPOINT) && (cloud_seq > app_totals_seq())) {
+		LOG_WRN("Cloud totals are newer than flash (seq %llu > %u), using them",
+			cloud_seq, app_totals_seq());
+		msg.op = TOTALS_OVERRIDE;
+		app_totals_set_seq((uint32_t)MIN(cloud_seq, UINT32_MAX));
+	} else if (IS_ENABLED(CONFIG_APP_TOTALS_CHECKPOINT) && (cloud_seq == app_totals_seq())) {
+		msg.op = TOTALS_MAX;
+	}
+
+	post_totals_msg(&msg);
+	atomic_set(&cumulative_checked, true);
+	return;
+
 cumulative_decode_error:
 	LOG_ERR("ZCBOR Decoding Error");
 	LOG_HEXDUMP_ERR(payload, payload_size, "cbor_payload");
@@ -314,6 +1064,11 @@ void app_work_on_connect(void)
 	/* Get cumulative "on" time from Golioth LightDB State */
 	int err;
 
+	/* Reconcile with the cloud once per boot */
+	if (atomic_get(&cumulative_checked)) {
+		return;
+	}
+
 	err = golioth_lightdb_get_async(client,
 					ADC_CUMULATIVE_ENDP,
 					GOLIOTH_CONTENT_TYPE_CBOR,
@@ -328,82 +1083,83 @@ void app_work_on_connect(void)
 /* do all of your work here! */
 void app_sensors_read_and_stream(void)
 {
-	struct mcp3201_data ch0_data, ch1_data;
+	struct adc_snapshot snaps[ADC_NUM_CHANNELS];
+	struct sensor_record rec = {0};
+	struct acq_stats stats;
+	uint64_t t_report = app_bench_start();
+	uint32_t t_metrics = app_metrics_now();
+
+	IF_ENABLED(CONFIG_APP_LOW_POWER, (
+		run_burst();
+		app_power_roll_interval();
+	));
 
 	/* Golioth custom hardware for demos */
 	IF_ENABLED(CONFIG_ALUDEL_BATTERY_MONITOR, (
 		read_and_report_battery(client);
-		IF_ENABLED(CONFIG_LIB_OSTENTUS, (
-			ostentus_slide_set(o_dev,
-					   BATTERY_V,
-					   get_batt_v_str(),
-					   strlen(get_batt_v_str()));
-			ostentus_slide_set(o_dev,
-					   BATTERY_PCT,
-					   get_batt_pct_str(),
-					   strlen(get_batt_pct_str()));
-		));
+		app_display_set_text(BATTERY_V, get_batt_v_str());
+		app_display_set_text(BATTERY_PCT, get_batt_pct_str());
 	));
 
-	get_adc_reading(&adc_ch0, &ch0_data);
-	get_adc_reading(&adc_ch1, &ch1_data);
+	app_sensors_get_acq_stats(&stats);
+	APP_LOG_INF_RATELIMIT("Acquisition: %u Hz achieved, %u missed sample periods",
+			      stats.rate_hz, stats.missed);
 
-	/* Calculate the "On" time if readings are not zero */
-	update_ontime(ch0_data.val1, &adc_ch0);
-	update_ontime(ch1_data.val1, &adc_ch1);
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		static struct app_log_limit errors_limit[ADC_NUM_CHANNELS];
+		atomic_val_t errors = atomic_clear(&adc_nodes[i].read_errors);
 
-	if (k_sem_take(&adc_data_sem, K_MSEC(300)) == 0) {
-		LOG_DBG("Ontime:\t(ch0): %lld\t(ch1): %lld", adc_ch0.runtime, adc_ch1.runtime);
-		k_sem_give(&adc_data_sem);
+		if (errors) {
+			APP_LOG_WRN_RATELIMIT_ON(&errors_limit[i],
+						 "mcp3201_ch%d: %ld failed reads since last report",
+						 adc_nodes[i].ch_num, errors);
+		}
 	}
 
-	/* Send sensor data to Golioth */
-	/* Two values were read for each sensor but we'll record only one from each
-	 * channel as it's unlikely the two readings will be substantially
-	 * different.
-	 */
-	push_adc_to_golioth(ch0_data.val1, ch1_data.val1);
-
-	IF_ENABLED(CONFIG_LIB_OSTENTUS, (
-		/* Update slide values on Ostentus
-		 * - values should be sent as strings
-		 * - use the enum from app_work.h for slide key values
-		 */
-		char json_buf[128];
-
-		snprintk(json_buf, sizeof(json_buf), "%.2f A", (double)(ch0_data.val1 * ADC_RAW_TO_AMP));
-		ostentus_slide_set(o_dev, CH0_CURRENT, json_buf, strlen(json_buf));
-
-		snprintk(json_buf, sizeof(json_buf), "%.2f A", (double)(ch1_data.val1 * ADC_RAW_TO_AMP));
-		ostentus_slide_set(o_dev, CH1_CURRENT, json_buf, strlen(json_buf));
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		static struct app_log_limit ontime_limit[ADC_NUM_CHANNELS];
 
-		if (k_sem_take(&adc_data_sem, K_MSEC(300)) == 0) {
-			snprintk(json_buf, sizeof(json_buf), "%lld s", (adc_ch0.runtime / 1000));
-			ostentus_slide_set(o_dev, CH0_ONTIME, json_buf, strlen(json_buf));
-
-			snprintk(json_buf, sizeof(json_buf), "%lld s", (adc_ch1.runtime / 1000));
-			ostentus_slide_set(o_dev, CH1_ONTIME, json_buf, strlen(json_buf));
+		app_sensors_get_snapshot(i, &snaps[i]);
+		rec.ua[i] = snaps[i].rms_ua;
+		APP_LOG_DBG_RATELIMIT_ON(&ontime_limit[i], "Ontime (%s): %lld", adc_nodes[i].key,
+					 snaps[i].runtime_ms);
+	}
 
-			k_sem_give(&adc_data_sem);
-		}
-	));
+	/* Send sensor data to Golioth */
+	/* Sampling runs continuously in its own thread; report the RMS current
+	 * of the most recent window for each channel.
+	 */
+	rec.ts_ms = k_uptime_get();
+	push_adc_to_golioth(&rec);
+	app_bench_stop(BENCH_REPORT, t_report);
+	app_metrics_record(METRICS_REPORT, t_metrics);
+
+	/* Only queued here; the display work queue talks to the faceplate */
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		app_display_set_current(i, rec.ua[i]);
+		app_display_set_ontime(i, snaps[i].runtime_ms);
+	}
 }
 
 void app_sensors_init(void)
 {
-	k_sem_init(&adc_data_sem, 0, 1);
+	LOG_DBG("Setting up current clamp ADCs...");
+	for (size_t i = 0; i < ARRAY_SIZE(adc_nodes); i++) {
+		const struct spi_dt_spec *spi = &adc_nodes[i].spi;
+
+		LOG_DBG("mcp3201_%s.bus = %p", adc_nodes[i].key, spi->bus);
+		LOG_DBG("mcp3201_%s.config.cs.gpio.port = %s", adc_nodes[i].key,
+			spi->config.cs.gpio.port->name);
+		LOG_DBG("mcp3201_%s.config.cs.gpio.pin = %u", adc_nodes[i].key,
+			spi->config.cs.gpio.pin);
+	}
 
+	LOG_INF("Sampling %zu channels at %d Hz", ARRAY_SIZE(adc_nodes), CONFIG_APP_SAMPLE_RATE_HZ);
 
-	LOG_DBG("Setting up current clamp ADCs...");
-	LOG_DBG("mcp3201_ch0.bus = %p", adc_ch0.spi.bus);
-	LOG_DBG("mcp3201_ch0.config.cs.gpio.port = %s", adc_ch0.spi.config.cs.gpio.port->name);
-	LOG_DBG("mcp3201_ch0.config.cs.gpio.pin = %u", adc_ch0.spi.config.cs.gpio.pin);
-	LOG_DBG("mcp3201_ch1.bus = %p", adc_ch1.spi.bus);
-	LOG_DBG("mcp3201_ch1.config.cs.gpio.port = %s", adc_ch1.spi.config.cs.gpio.port->name);
-	LOG_DBG("mcp3201_ch1.config.cs.gpio.pin = %u", adc_ch1.spi.config.cs.gpio.pin);
-
-	/* Semaphores to handle data access */
-	k_sem_give(&adc_data_sem);
+	/* The bus is only resumed for sampling bursts */
+	IF_ENABLED(CONFIG_APP_LOW_POWER, (spi_buses_action(PM_DEVICE_ACTION_SUSPEND);));
+
+	k_thread_start(sampling_tid);
 }
 
 void app_sensors_set_client(struct golioth_client *sensors_client)
@@ -15,39 +15,147 @@
  */
 
 #include <stdint.h>
+#include <zephyr/devicetree.h>
 #include <zephyr/drivers/spi.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
 #include <golioth/client.h>
 
-extern struct k_sem adc_data_sem;
+/* One current clamp channel per enabled microchip,mcp3201 node */
+#define ADC_NUM_CHANNELS DT_NUM_INST_STATUS_OKAY(microchip_mcp3201)
 
-struct ontime {
-	uint64_t ch0;
-	uint64_t ch1;
+/* Channels are numbered by the reg (chip select) of their node */
+#define ADC_MAX_CHANNELS 8
+
+BUILD_ASSERT(ADC_NUM_CHANNELS > 0, "No enabled microchip,mcp3201 nodes in devicetree");
+BUILD_ASSERT(ADC_NUM_CHANNELS <= ADC_MAX_CHANNELS, "Too many microchip,mcp3201 nodes");
+
+/* 0.003529412 A per raw count, kept in nA for integer math */
+#define ADC_RAW_TO_NANOAMP (3529412ULL)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_APP_SAMPLE_BUFFER_LEN),
+	     "CONFIG_APP_SAMPLE_BUFFER_LEN must be a power of two");
+
+/* Running sums for one RMS window, updated once per sample */
+struct rms_acc {
+	uint32_t sum;
+	uint64_t sum_sq;
+	uint32_t count;
+};
+
+/*
+ * Buckets of the percentile sketch. Levels below BIT(AGG_SKETCH_SUB_BITS)
+ * get a bucket each, then every power of two up to AGG_SKETCH_VALUE_BITS
+ * is split into BIT(AGG_SKETCH_SUB_BITS) buckets.
+ */
+#define AGG_SKETCH_SUB_BITS   3
+#define AGG_SKETCH_VALUE_BITS 16
+#define AGG_SKETCH_BUCKETS    ((AGG_SKETCH_VALUE_BITS - AGG_SKETCH_SUB_BITS + 1) << AGG_SKETCH_SUB_BITS)
+
+/* RMS levels of every window since the previous record, in raw counts with
+ * fractional bits. The size does not depend on how many windows are added.
+ */
+struct agg_acc {
+	uint32_t count;
+	uint32_t min_q;
+	uint32_t max_q;
+	uint64_t sum_q;
+	uint64_t sum_sq_q;
+	uint32_t sketch[AGG_SKETCH_BUCKETS];
+};
+
+/* Statistics of the per-window RMS current between two records */
+struct ch_agg {
+	uint32_t min_ua;
+	uint32_t max_ua;
+	uint32_t mean_ua;
+	uint32_t rms_ua;
+	uint32_t p95_ua;
+	uint32_t p99_ua;
+};
+
+/* ON/OFF detector, written only by the sampling thread */
+struct onoff_fsm {
+	bool on;
+	/* Uptime at which the opposite condition was first seen, -1 if none */
+	int64_t edge_ms;
+	/* Uptime up to which ON time has been accounted */
+	int64_t committed_ms;
+	/* Smoothed RMS level in raw counts with fractional bits */
+	uint32_t smooth_q;
+	/* Time since the current ON transition */
+	uint64_t runtime_ms;
+	/* ON time and energy since boot, never reset */
+	uint64_t total_ms;
+	uint64_t total_mwh;
+	/* Energy below 1 mWh, in uA * V * PF% * ms */
+	uint64_t energy_frac;
+	/* Added to the totals to give the cumulative values */
+	int64_t base_ms;
+	int64_t base_mwh;
+	/* Cumulative values were loaded from the cloud or reset */
+	bool base_set;
+	/* state/cumulative has been read and applied */
+	bool reconciled;
+};
+
+/* Values published by the sampling thread once per RMS window */
+struct adc_snapshot {
+	uint32_t rms_ua;
+	bool on;
+	/* Cumulative values are valid */
+	bool loaded;
+	/* Cumulative values include the ones read from the cloud */
+	bool reconciled;
+	uint64_t runtime_ms;
+	uint64_t cumulative_ms;
+	uint64_t cumulative_mwh;
 };
 
 typedef struct {
 	const struct spi_dt_spec spi;
 	uint8_t ch_num;
-	int64_t laston;
-	uint64_t runtime;
-	uint64_t total_unreported;
-	uint64_t total_cloud;
-	bool loaded_from_cloud;
-
+	/* "chN", used as the key in every payload */
+	const char *key;
+	/* "chN_mwh", the energy key in state/cumulative */
+	const char *energy_key;
+	/* Written only by the sampling thread */
+	struct adc_snapshot snap;
+	/* Odd while snap is being written */
+	atomic_t snap_seq;
+	uint16_t samples[CONFIG_APP_SAMPLE_BUFFER_LEN];
+	atomic_t sample_count;
+	struct rms_acc rms;
+	/* The sampling thread fills one while the main loop reads the other */
+	struct agg_acc agg[2];
+	struct onoff_fsm fsm;
+	atomic_t read_errors;
 } adc_node_t;
 
+struct acq_stats {
+	/* Sample periods completed per second since the previous call */
+	uint32_t rate_hz;
+	/* Sample periods skipped because acquisition overran its deadline */
+	uint32_t missed;
+};
+
 void app_work_on_connect(void);
+const char *app_sensors_ch_key(uint8_t ch_num);
+const char *app_sensors_ch_energy_key(uint8_t ch_num);
+void app_sensors_get_snapshot(uint8_t ch_num, struct adc_snapshot *snap);
+void app_sensors_get_acq_stats(struct acq_stats *stats);
+uint32_t app_sensors_sample_rate_mhz(void);
 void app_sensors_read_and_stream(void);
-int get_ontime(struct ontime *ot);
+int app_sensors_get_samples(uint8_t ch_num, uint16_t *dst, size_t count);
+uint32_t app_sensors_sample_count(uint8_t ch_num);
 int reset_cumulative_totals(void);
+int load_cumulative_totals(const uint64_t *ms, const uint64_t *mwh);
 void app_sensors_init(void);
 void app_sensors_set_client(struct golioth_client *sensors_client);
 
-/* Ostentus slide labels */
-#define CH0_CUR_LABEL	"Current ch0"
-#define CH1_CUR_LABEL	"Current ch1"
-#define CH0_ONTIME_LBL  "Ontime ch0"
-#define CH1_ONTIME_LBL  "Ontime ch1"
+/* Ostentus slide labels, formatted with the channel key */
+#define CH_CUR_LABEL_FMT    "Current %s"
+#define CH_ONTIME_LABEL_FMT "Ontime %s"
 #define LABEL_BATTERY	"Battery"
 #define LABEL_FIRMWARE	"Firmware"
 #define SUMMARY_TITLE	"Channel 0:"
@@ -57,10 +165,9 @@ void app_sensors_set_client(struct golioth_client *sensors_client);
  * inserting elements with the name of your choice to this enum.
  */
 typedef enum {
-	CH0_CURRENT,
-	CH1_CURRENT,
-	CH0_ONTIME,
-	CH1_ONTIME,
+	CH_CURRENT_FIRST,
+	CH_ONTIME_FIRST = CH_CURRENT_FIRST + ADC_NUM_CHANNELS,
+	CH_SLIDES_LAST = CH_ONTIME_FIRST + ADC_NUM_CHANNELS - 1,
 #ifdef CONFIG_ALUDEL_BATTERY_MONITOR
 	BATTERY_V,
 	BATTERY_PCT,
@@ -68,4 +175,8 @@ typedef enum {
 	FIRMWARE
 } slide_key;
 
+/* Per-channel slides occupy a contiguous range of keys for each kind */
+#define CH_CURRENT_SLIDE(ch_num) ((slide_key)(CH_CURRENT_FIRST + (ch_num)))
+#define CH_ONTIME_SLIDE(ch_num)	 ((slide_key)(CH_ONTIME_FIRST + (ch_num)))
+
 #endif /* __APP_WORK_H__ */
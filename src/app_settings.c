@@ -7,27 +7,109 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(app_settings, LOG_LEVEL_DBG);
 
+#include <zephyr/sys/__assert.h>
 #include <golioth/client.h>
 #include <golioth/settings.h>
 #include "main.h"
+#include "app_sensors.h"
 #include "app_settings.h"
 
-static int32_t _loop_delay_s = 60;
-static uint16_t _adc_floor[2] = {0, 0};
-
 #define LOOP_DELAY_S_MAX 43200
 #define LOOP_DELAY_S_MIN 1
 #define ADC_FLOOR_MIN 0
 #define ADC_FLOOR_MAX 65535
+#define ADC_FLOOR_KEY_LEN sizeof("ADC_FLOOR_CH255")
+#define ADC_HYSTERESIS_MIN 0
+#define ADC_HYSTERESIS_MAX 4095
+#define DWELL_MS_MIN 0
+#define DWELL_MS_MAX 60000
+#define LINE_VOLTAGE_MIN 1
+#define LINE_VOLTAGE_MAX 1000
+#define POWER_FACTOR_PCT_MIN 1
+#define POWER_FACTOR_PCT_MAX 100
+#define BATCH_SIZE_MIN 1
+#define BATCH_SIZE_MAX CONFIG_APP_BATCH_MAX_RECORDS
+#define BATCH_MAX_AGE_S_MIN 1
+#define BATCH_MAX_AGE_S_MAX 86400
+#define DEADBAND_MA_MIN 0
+#define DEADBAND_MA_MAX 100000
+#define DEADBAND_PCT_MIN 0
+#define DEADBAND_PCT_MAX 100
+#define HEARTBEAT_S_MIN 1
+#define HEARTBEAT_S_MAX 86400
+
+static int32_t _loop_delay_s = CONFIG_APP_LOOP_DEFAULT_DELAY_S;
+static uint16_t _adc_floor[ADC_NUM_CHANNELS];
+static char adc_floor_keys[ADC_NUM_CHANNELS][ADC_FLOOR_KEY_LEN];
+static uint16_t _adc_hysteresis = 8;
+static int32_t _on_dwell_ms = 300;
+static int32_t _off_dwell_ms = 2000;
+static int32_t _line_voltage = 120;
+static int32_t _power_factor_pct = 100;
+static int32_t _batch_size = CONFIG_APP_BATCH_DEFAULT_RECORDS;
+static int32_t _batch_max_age_s = CONFIG_APP_BATCH_DEFAULT_MAX_AGE_S;
+static int32_t _deadband_ma = 50;
+static int32_t _deadband_pct = 5;
+static int32_t _heartbeat_s = 3600;
 
 int32_t get_loop_delay_s(void)
 {
 	return _loop_delay_s;
 }
 
+int32_t get_batch_size(void)
+{
+	return _batch_size;
+}
+
+int32_t get_batch_max_age_s(void)
+{
+	return _batch_max_age_s;
+}
+
+int32_t get_deadband_ma(void)
+{
+	return _deadband_ma;
+}
+
+int32_t get_deadband_pct(void)
+{
+	return _deadband_pct;
+}
+
+int32_t get_heartbeat_s(void)
+{
+	return _heartbeat_s;
+}
+
+uint16_t get_adc_hysteresis(void)
+{
+	return _adc_hysteresis;
+}
+
+int32_t get_on_dwell_ms(void)
+{
+	return _on_dwell_ms;
+}
+
+int32_t get_off_dwell_ms(void)
+{
+	return _off_dwell_ms;
+}
+
+int32_t get_line_voltage(void)
+{
+	return _line_voltage;
+}
+
+int32_t get_power_factor_pct(void)
+{
+	return _power_factor_pct;
+}
+
 uint16_t get_adc_floor(uint8_t ch_num)
 {
-	if (ch_num >= sizeof(_adc_floor)) {
+	if (ch_num >= ARRAY_SIZE(_adc_floor)) {
 		return 0;
 	} else {
 		return _adc_floor[ch_num];
@@ -42,63 +124,175 @@ static enum golioth_settings_status on_loop_delay_setting(int32_t new_value, voi
 	return GOLIOTH_SETTINGS_SUCCESS;
 }
 
+static enum golioth_settings_status on_adc_hysteresis_setting(int32_t new_value, void *arg)
+{
+	_adc_hysteresis = new_value;
+	LOG_INF("Set ADC_HYSTERESIS to %i", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_dwell_setting(int32_t new_value, void *arg)
+{
+	int32_t *dwell_ms = arg;
+
+	*dwell_ms = new_value;
+	LOG_INF("Set %s dwell time to %i ms", (dwell_ms == &_on_dwell_ms) ? "ON" : "OFF",
+		new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_line_voltage_setting(int32_t new_value, void *arg)
+{
+	_line_voltage = new_value;
+	LOG_INF("Set line voltage to %i V", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_power_factor_setting(int32_t new_value, void *arg)
+{
+	_power_factor_pct = new_value;
+	LOG_INF("Set power factor to %i %%", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_batch_size_setting(int32_t new_value, void *arg)
+{
+	_batch_size = new_value;
+	LOG_INF("Set batch size to %i records", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_batch_max_age_setting(int32_t new_value, void *arg)
+{
+	_batch_max_age_s = new_value;
+	LOG_INF("Set batch max age to %i seconds", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_deadband_ma_setting(int32_t new_value, void *arg)
+{
+	_deadband_ma = new_value;
+	LOG_INF("Set deadband to %i mA", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_deadband_pct_setting(int32_t new_value, void *arg)
+{
+	_deadband_pct = new_value;
+	LOG_INF("Set deadband to %i %%", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
+static enum golioth_settings_status on_heartbeat_setting(int32_t new_value, void *arg)
+{
+	_heartbeat_s = new_value;
+	LOG_INF("Set heartbeat interval to %i seconds", new_value);
+	return GOLIOTH_SETTINGS_SUCCESS;
+}
+
 static enum golioth_settings_status on_adc_floor_setting(int32_t new_value, void *arg)
 {
 	size_t ch_num = (size_t) arg;
 
-	if (ch_num > 1)
-	{
-		LOG_ERR("Invalid channel number: %d", ch_num);
+	if (ch_num >= ARRAY_SIZE(_adc_floor)) {
+		LOG_ERR("Invalid channel number: %zu", ch_num);
 		return GOLIOTH_SETTINGS_GENERAL_ERROR;
 	}
 
 	/* Only update if value has changed */
 	if (_adc_floor[ch_num] == new_value) {
-		LOG_DBG("Received ADC_FLOOR_CH%d already matches local value.", ch_num);
+		LOG_DBG("Received ADC_FLOOR_CH%zu already matches local value.", ch_num);
 	} else {
 		_adc_floor[ch_num] = new_value;
-		LOG_INF("Set ADC_FLOOR_CH%d to %d", ch_num, _adc_floor[ch_num]);
+		LOG_INF("Set ADC_FLOOR_CH%zu to %d", ch_num, _adc_floor[ch_num]);
 	}
 
 	wake_system_thread();
 	return GOLIOTH_SETTINGS_SUCCESS;
 }
 
-void app_settings_register(struct golioth_client *client)
-{
-	int err;
-	struct golioth_settings *settings = golioth_settings_init(client);
+/* Registered by app_settings_register(): one per row of fixed_settings,
+ * plus ADC_FLOOR_CHn for every channel
+ */
+#define FIXED_SETTINGS_COUNT 11
+#define SETTINGS_COUNT	     (FIXED_SETTINGS_COUNT + ADC_NUM_CHANNELS)
 
-	err = golioth_settings_register_int_with_range(settings,
-							   "LOOP_DELAY_S",
-							   LOOP_DELAY_S_MIN,
-							   LOOP_DELAY_S_MAX,
-							   on_loop_delay_setting,
-							   NULL);
+BUILD_ASSERT(SETTINGS_COUNT <= CONFIG_GOLIOTH_MAX_NUM_SETTINGS,
+	     "CONFIG_GOLIOTH_MAX_NUM_SETTINGS is too low for the number of channels");
+
+struct int_setting {
+	const char *name;
+	int32_t min;
+	int32_t max;
+	golioth_int_setting_cb cb;
+	void *arg;
+};
+
+static const struct int_setting fixed_settings[] = {
+	{"LOOP_DELAY_S", LOOP_DELAY_S_MIN, LOOP_DELAY_S_MAX, on_loop_delay_setting, NULL},
+	{"BATCH_SIZE", BATCH_SIZE_MIN, BATCH_SIZE_MAX, on_batch_size_setting, NULL},
+	{"BATCH_MAX_AGE_S", BATCH_MAX_AGE_S_MIN, BATCH_MAX_AGE_S_MAX, on_batch_max_age_setting,
+	 NULL},
+	{"ADC_HYSTERESIS", ADC_HYSTERESIS_MIN, ADC_HYSTERESIS_MAX, on_adc_hysteresis_setting,
+	 NULL},
+	{"ON_DWELL_MS", DWELL_MS_MIN, DWELL_MS_MAX, on_dwell_setting, &_on_dwell_ms},
+	{"OFF_DWELL_MS", DWELL_MS_MIN, DWELL_MS_MAX, on_dwell_setting, &_off_dwell_ms},
+	{"LINE_VOLTAGE", LINE_VOLTAGE_MIN, LINE_VOLTAGE_MAX, on_line_voltage_setting, NULL},
+	{"POWER_FACTOR_PCT", POWER_FACTOR_PCT_MIN, POWER_FACTOR_PCT_MAX, on_power_factor_setting,
+	 NULL},
+	{"DEADBAND_MA", DEADBAND_MA_MIN, DEADBAND_MA_MAX, on_deadband_ma_setting, NULL},
+	{"DEADBAND_PCT", DEADBAND_PCT_MIN, DEADBAND_PCT_MAX, on_deadband_pct_setting, NULL},
+	{"HEARTBEAT_S", HEARTBEAT_S_MIN, HEARTBEAT_S_MAX, on_heartbeat_setting, NULL},
+};
+
+BUILD_ASSERT(ARRAY_SIZE(fixed_settings) == FIXED_SETTINGS_COUNT);
+
+static int register_setting(struct golioth_settings *settings, const struct int_setting *s)
+{
+	int err = golioth_settings_register_int_with_range(settings, s->name, s->min, s->max,
+							   s->cb, s->arg);
 
 	if (err) {
-		LOG_ERR("Failed to register loop_delay settings callback: %d", err);
+		LOG_ERR("Failed to register %s settings callback: %d", s->name, err);
 	}
 
-	err = golioth_settings_register_int_with_range(settings,
-							   "ADC_FLOOR_CH0",
-							   ADC_FLOOR_MIN,
-							   ADC_FLOOR_MAX,
-							   on_adc_floor_setting,
-							   (void *) 0);
+	return err;
+}
 
-	if (err) {
-		LOG_ERR("Failed to register ADC_FLOOR_CH0 settings callback: %d", err);
+int app_settings_register(struct golioth_client *client)
+{
+	struct golioth_settings *settings = golioth_settings_init(client);
+	int failed = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(fixed_settings); i++) {
+		if (register_setting(settings, &fixed_settings[i])) {
+			failed++;
+		}
 	}
 
-	err = golioth_settings_register_int_with_range(settings,
-							   "ADC_FLOOR_CH1",
-							   ADC_FLOOR_MIN,
-							   ADC_FLOOR_MAX,
-							   on_adc_floor_setting,
-							   (void *) 1);
+	for (size_t ch = 0; ch < ARRAY_SIZE(_adc_floor); ch++) {
+		/* The settings service keeps a pointer to the key */
+		snprintk(adc_floor_keys[ch], sizeof(adc_floor_keys[ch]), "ADC_FLOOR_CH%zu", ch);
 
-	if (err) {
-		LOG_ERR("Failed to register ADC_FLOOR_CH1 settings callback: %d", err);
+		const struct int_setting floor = {
+			adc_floor_keys[ch], ADC_FLOOR_MIN, ADC_FLOOR_MAX, on_adc_floor_setting,
+			(void *)ch,
+		};
+
+		if (register_setting(settings, &floor)) {
+			failed++;
+		}
 	}
+
+	if (failed) {
+		/* Unregistered settings silently keep their defaults, so this
+		 * must not go unnoticed
+		 */
+		LOG_ERR("%d of %d settings not registered, check CONFIG_GOLIOTH_MAX_NUM_SETTINGS",
+			failed, SETTINGS_COUNT);
+		__ASSERT(false, "Settings registration failed");
+		return -ENOMEM;
+	}
+
+	return 0;
 }
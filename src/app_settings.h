@@ -18,7 +18,17 @@
 #include <golioth/client.h>
 
 uint16_t get_adc_floor(uint8_t ch_num);
+uint16_t get_adc_hysteresis(void);
+int32_t get_line_voltage(void);
+int32_t get_power_factor_pct(void);
+int32_t get_on_dwell_ms(void);
+int32_t get_off_dwell_ms(void);
 int32_t get_loop_delay_s(void);
-void app_settings_register(struct golioth_client *client);
+int32_t get_batch_size(void);
+int32_t get_batch_max_age_s(void);
+int32_t get_deadband_ma(void);
+int32_t get_deadband_pct(void);
+int32_t get_heartbeat_s(void);
+int app_settings_register(struct golioth_client *client);
 
 #endif /* __APP_SETTINGS_H__ */
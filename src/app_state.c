@@ -7,22 +7,31 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(app_state, LOG_LEVEL_DBG);
 
+#include <string.h>
 #include <golioth/client.h>
 #include <golioth/lightdb_state.h>
 #include <zcbor_decode.h>
 #include <zcbor_encode.h>
 
 #include "main.h"
+#include "app_bench.h"
+#include "app_log.h"
+#include "app_metrics.h"
 #include "app_sensors.h"
 #include "app_state.h"
+#include "app_totals.h"
 
-#define LIVE_RUNTIME_FMT "{\"live_runtime\":{\"ch0\":%lld,\"ch1\":%lld}"
-#define CUMULATIVE_RUNTIME_FMT ",\"cumulative\":{\"ch0\":%lld,\"ch1\":%lld}}"
-#define DEVICE_STATE_FMT LIVE_RUNTIME_FMT "}"
-#define DEVICE_STATE_FMT_CUMULATIVE LIVE_RUNTIME_FMT CUMULATIVE_RUNTIME_FMT
+/* Worst case per channel: "chN" + u64 in live_runtime, then "chN" + u64 and
+ * "chN_mwh" + u64 in cumulative. Cumulative also carries "seq" + u32.
+ */
+#define STATE_CBOR_PER_CH (3 * (1 + sizeof("ch255_mwh") + 9))
+#define STATE_CBOR_MAX	  (32 + 9 + (ADC_NUM_CHANNELS * STATE_CBOR_PER_CH))
 
 static struct golioth_client *client;
-static struct ontime ot;
+static struct adc_snapshot snaps[ADC_NUM_CHANNELS];
+static uint32_t snaps_seq;
+static uint8_t state_buf[STATE_CBOR_MAX];
+static K_MUTEX_DEFINE(state_buf_lock);
 
 static K_SEM_DEFINE(update_actual, 0, 1);
 
@@ -33,85 +42,147 @@ static void async_handler(struct golioth_client *client,
 			  void *arg)
 {
 	if (status != GOLIOTH_OK) {
-		LOG_WRN("Failed to set state: %d", status);
+		APP_LOG_WRN_RATELIMIT("Failed to set state: %d", status);
+		app_metrics_inc(METRICS_ASYNC_ERRORS);
 		return;
 	}
 
 	LOG_DBG("State successfully set");
 }
 
-static int app_state_update_actual(void)
+static bool encode_key(zcbor_state_t *zse, const char *key)
+{
+	return zcbor_tstr_encode_ptr(zse, key, strlen(key));
+}
+
+/*
+ * {"live_runtime": {"ch0": .., ...}} or, once the totals have been loaded
+ * from the cloud,
+ * {"live_runtime": {...}, "cumulative": {"seq": .., "ch0": .., "ch0_mwh": .., ...}}
+ */
+static int encode_state(bool cumulative, size_t *len)
 {
+	size_t entries = cumulative ? 2 : 1;
+	bool ok;
+
+	ZCBOR_STATE_E(zse, 2, state_buf, sizeof(state_buf), 1);
+
+	ok = zcbor_map_start_encode(zse, entries) &&
+	     zcbor_tstr_put_lit(zse, "live_runtime") &&
+	     zcbor_map_start_encode(zse, ADC_NUM_CHANNELS);
+
+	for (uint8_t ch = 0; ok && (ch < ADC_NUM_CHANNELS); ch++) {
+		ok = encode_key(zse, app_sensors_ch_key(ch)) &&
+		     zcbor_uint64_put(zse, snaps[ch].runtime_ms);
+	}
+
+	ok = ok && zcbor_map_end_encode(zse, ADC_NUM_CHANNELS);
+
+	if (cumulative) {
+		ok = ok && zcbor_tstr_put_lit(zse, "cumulative") &&
+		     zcbor_map_start_encode(zse, 1 + (2 * ADC_NUM_CHANNELS)) &&
+		     zcbor_tstr_put_lit(zse, "seq") &&
+		     zcbor_uint32_put(zse, snaps_seq);
+
+		for (uint8_t ch = 0; ok && (ch < ADC_NUM_CHANNELS); ch++) {
+			ok = encode_key(zse, app_sensors_ch_key(ch)) &&
+			     zcbor_uint64_put(zse, snaps[ch].cumulative_ms) &&
+			     encode_key(zse, app_sensors_ch_energy_key(ch)) &&
+			     zcbor_uint64_put(zse, snaps[ch].cumulative_mwh);
+		}
+
+		ok = ok && zcbor_map_end_encode(zse, 1 + (2 * ADC_NUM_CHANNELS));
+	}
+
+	ok = ok && zcbor_map_end_encode(zse, entries);
+	if (!ok) {
+		LOG_ERR("Failed to encode state: %d", zcbor_peek_error(zse));
+		return -ENOMEM;
+	}
+
+	*len = zse->payload - state_buf;
+
+	return 0;
+}
+
+/* Snapshot every channel and write the state, with cumulative values if
+ * they are known.
+ */
+static int app_state_write(bool with_cumulative, bool *cumulative_sent)
+{
+	bool loaded = true;
+	uint64_t t;
+	size_t len;
 	int err;
-	char sbuf[sizeof(DEVICE_STATE_FMT) + 10]; /* space for uint16 values */
 
-	err = get_ontime(&ot);
+	k_mutex_lock(&state_buf_lock, K_FOREVER);
+
+	/* Read before the totals so the values are never older than the
+	 * checkpoint the sequence number refers to
+	 */
+	snaps_seq = app_totals_seq();
+
+	for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+		app_sensors_get_snapshot(ch, &snaps[ch]);
+		/* Until state/cumulative is read, a report made with totals
+		 * restored from flash could reach the cloud first and be
+		 * counted again when the read value is merged
+		 */
+		loaded = loaded && snaps[ch].loaded && snaps[ch].reconciled;
+	}
 
+	with_cumulative = with_cumulative && loaded;
+
+	t = app_bench_start();
+	err = encode_state(with_cumulative, &len);
+	app_bench_stop(BENCH_ENCODE_STATE, t);
 	if (err) {
-		LOG_ERR("Failed to retrieve ontime: %d", err);
-		return err;
+		goto unlock;
 	}
 
-	snprintk(sbuf, sizeof(sbuf), DEVICE_STATE_FMT, ot.ch0, ot.ch1);
+	t = app_bench_start();
 	err = golioth_lightdb_set_async(client,
 					APP_STATE_ACTUAL_ENDP,
-					GOLIOTH_CONTENT_TYPE_JSON,
-					sbuf,
-					strlen(sbuf),
+					GOLIOTH_CONTENT_TYPE_CBOR,
+					state_buf,
+					len,
 					async_handler,
 					NULL);
+	app_bench_stop(BENCH_ENQUEUE, t);
 	if (err) {
 		LOG_ERR("Unable to write to LightDB State: %d", err);
+		app_metrics_inc(METRICS_ENQUEUE_FAILED);
+	}
+
+	if (cumulative_sent) {
+		*cumulative_sent = with_cumulative;
 	}
 
+unlock:
+	k_mutex_unlock(&state_buf_lock);
+
 	return err;
 }
 
-int app_state_report_ontime(adc_node_t *ch0, adc_node_t *ch1)
+static int app_state_update_actual(void)
+{
+	return app_state_write(false, NULL);
+}
+
+int app_state_report_ontime(void)
 {
+	bool cumulative_sent = false;
 	int err;
-	char json_buf[128];
-
-	if (k_sem_take(&adc_data_sem, K_MSEC(300)) == 0) {
-
-		if (ch0->loaded_from_cloud) {
-			snprintk(json_buf, sizeof(json_buf), DEVICE_STATE_FMT_CUMULATIVE,
-				 ch0->runtime, ch1->runtime,
-				 (ch0->total_cloud + ch0->total_unreported),
-				 (ch1->total_cloud + ch1->total_unreported));
-		} else {
-			snprintk(json_buf, sizeof(json_buf), DEVICE_STATE_FMT, ch0->runtime, ch1->runtime);
-			/* Cumulative not yet loaded from LightDB State */
-			/* Try to load it now */
-			app_work_on_connect();
-		}
-
 
-		err = golioth_lightdb_set_async(client,
-						APP_STATE_ACTUAL_ENDP,
-						GOLIOTH_CONTENT_TYPE_JSON,
-						json_buf,
-						strlen(json_buf),
-						async_handler,
-						NULL);
-		if (err) {
-			LOG_ERR("Failed to send sensor data to Golioth: %d", err);
-			k_sem_give(&adc_data_sem);
+	err = app_state_write(true, &cumulative_sent);
 
-			return err;
-		}
-
-		if (ch0->loaded_from_cloud) {
-			ch0->total_cloud += ch0->total_unreported;
-			ch0->total_unreported = 0;
-			ch1->total_cloud += ch1->total_unreported;
-			ch1->total_unreported = 0;
-		}
-
-		k_sem_give(&adc_data_sem);
+	if (!err && !cumulative_sent) {
+		/* Cumulative not yet loaded from LightDB State */
+		/* Try to load it now */
+		app_work_on_connect();
 	}
 
-	return 0;
+	return err;
 }
 
 int app_state_observe(struct golioth_client *state_client)
@@ -20,6 +20,6 @@
 #define APP_STATE_ACTUAL_ENDP  "state"
 
 int app_state_observe(struct golioth_client *state_client);
-int app_state_report_ontime(adc_node_t *ch0, adc_node_t *ch1);
+int app_state_report_ontime(void);
 
 #endif /* __APP_STATE_H__ */
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __APP_TIME_H__
+#define __APP_TIME_H__
+
+#include <errno.h>
+#include <stdint.h>
+
+#ifdef CONFIG_DATE_TIME
+#include <date_time.h>
+#elif defined(CONFIG_BOARD_NATIVE_SIM)
+#include <native_rtc.h>
+#include <zephyr/kernel.h>
+#endif
+
+/**
+ * Convert a k_uptime_get() value to Unix time in milliseconds, in place.
+ *
+ * Records are stamped with uptime when they are taken and converted only
+ * when they leave RAM, so they can be taken before network time is known.
+ *
+ * @retval 0 on success
+ * @retval <0 if wall clock time is not available (yet)
+ */
+static inline int app_time_uptime_to_unix_ms(int64_t *ts)
+{
+#ifdef CONFIG_DATE_TIME
+	return date_time_uptime_to_unix_time_ms(ts);
+#elif defined(CONFIG_BOARD_NATIVE_SIM)
+	/* The host clock stands in for network time */
+	*ts += (int64_t)(native_rtc_gettime_us(RTC_CLOCK_REALTIME) / USEC_PER_MSEC) - k_uptime_get();
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+#endif /* __APP_TIME_H__ */
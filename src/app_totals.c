@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_totals, LOG_LEVEL_DBG);
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+
+#include "app_sensors.h"
+#include "app_totals.h"
+
+#define TOTALS_SETTINGS_TREE "totals"
+#define TOTALS_SETTINGS_NAME "cp"
+#define TOTALS_SETTINGS_KEY  TOTALS_SETTINGS_TREE "/" TOTALS_SETTINGS_NAME
+
+struct totals_checkpoint {
+	uint64_t ms[ADC_NUM_CHANNELS];
+	uint64_t mwh[ADC_NUM_CHANNELS];
+	uint32_t seq;
+};
+
+/* Last checkpoint written or restored, only touched by the work handler
+ * once the settings have been loaded
+ */
+static struct totals_checkpoint saved;
+static struct totals_checkpoint next;
+
+/* Sequence number of the newest checkpoint in flash */
+static atomic_t checkpoint_seq;
+
+static void checkpoint_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(checkpoint_work, checkpoint_work_handler);
+
+static int totals_settings_set(const char *name, size_t len, settings_read_cb read_cb,
+			       void *cb_arg)
+{
+	const char *next_name;
+	ssize_t rc;
+
+	if (!settings_name_steq(name, TOTALS_SETTINGS_NAME, &next_name) || next_name) {
+		return -ENOENT;
+	}
+
+	/* A checkpoint from a build with a different channel count is ignored
+	 * and the totals are loaded from the cloud instead.
+	 */
+	if (len != sizeof(saved)) {
+		LOG_WRN("Ignoring checkpoint of %zu bytes, expected %zu", len, sizeof(saved));
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, &saved, sizeof(saved));
+	if (rc != sizeof(saved)) {
+		LOG_ERR("Failed to read checkpoint: %d", (int)rc);
+		saved = (struct totals_checkpoint){0};
+		return (rc < 0) ? rc : -EIO;
+	}
+
+	atomic_set(&checkpoint_seq, saved.seq);
+
+	LOG_INF("Restored cumulative totals from flash, seq %u", saved.seq);
+
+	return load_cumulative_totals(saved.ms, saved.mwh);
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_totals, TOTALS_SETTINGS_TREE, NULL, totals_settings_set, NULL,
+			       NULL);
+
+/* Serializes the periodic checkpoint with app_totals_checkpoint_now() */
+static K_MUTEX_DEFINE(checkpoint_lock);
+
+static int checkpoint(void)
+{
+	struct adc_snapshot snap;
+	bool changed = false;
+	int err;
+
+	for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++) {
+		app_sensors_get_snapshot(ch, &snap);
+
+		/* Never overwrite a checkpoint before the totals are known */
+		if (!snap.loaded) {
+			return -EAGAIN;
+		}
+
+		next.ms[ch] = snap.cumulative_ms;
+		next.mwh[ch] = snap.cumulative_mwh;
+		changed = changed || (next.ms[ch] != saved.ms[ch]) ||
+			  (next.mwh[ch] != saved.mwh[ch]);
+	}
+
+	/* Nothing ran since the last checkpoint: skip the flash write */
+	if (!changed) {
+		return 0;
+	}
+
+	next.seq = (uint32_t)atomic_get(&checkpoint_seq) + 1;
+
+	err = settings_save_one(TOTALS_SETTINGS_KEY, &next, sizeof(next));
+	if (err) {
+		LOG_ERR("Failed to save checkpoint: %d", err);
+		return err;
+	}
+
+	saved = next;
+	atomic_set(&checkpoint_seq, next.seq);
+
+	LOG_DBG("Saved cumulative totals, seq %u", next.seq);
+
+	return 0;
+}
+
+static void checkpoint_work_handler(struct k_work *work)
+{
+	k_work_schedule(&checkpoint_work, K_SECONDS(CONFIG_APP_TOTALS_CHECKPOINT_INTERVAL_S));
+
+	k_mutex_lock(&checkpoint_lock, K_FOREVER);
+	checkpoint();
+	k_mutex_unlock(&checkpoint_lock);
+}
+
+int app_totals_checkpoint_now(void)
+{
+	int err;
+
+	k_mutex_lock(&checkpoint_lock, K_FOREVER);
+	err = checkpoint();
+	k_mutex_unlock(&checkpoint_lock);
+
+	return err;
+}
+
+void app_totals_request_checkpoint(void)
+{
+	k_work_reschedule(&checkpoint_work, K_NO_WAIT);
+}
+
+uint32_t app_totals_seq(void)
+{
+	return (uint32_t)atomic_get(&checkpoint_seq);
+}
+
+void app_totals_set_seq(uint32_t seq)
+{
+	atomic_val_t cur;
+
+	/* Only ever move forward so the cloud never sees a sequence reused */
+	do {
+		cur = atomic_get(&checkpoint_seq);
+		if ((uint32_t)cur >= seq) {
+			return;
+		}
+	} while (!atomic_cas(&checkpoint_seq, cur, seq));
+}
+
+void app_totals_start(void)
+{
+	k_work_schedule(&checkpoint_work, K_SECONDS(CONFIG_APP_TOTALS_CHECKPOINT_INTERVAL_S));
+}
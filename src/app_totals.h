@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Checkpoint the cumulative on time and energy of every channel to flash
+ * with the settings subsystem, so they are restored at boot before the
+ * network is up instead of waiting for a LightDB State round trip.
+ *
+ * Changes are coalesced and written at most once per
+ * CONFIG_APP_TOTALS_CHECKPOINT_INTERVAL_S to bound flash wear. Every
+ * checkpoint increments a sequence number that is also reported in
+ * `state/cumulative`. At boot the cloud value replaces the restored one
+ * if its sequence number is newer, which happens when flash was erased or
+ * rolled back. With the same sequence number the cloud holds reports made
+ * after the checkpoint, so the larger of the two is kept per channel.
+ * app_totals_checkpoint_now() is called before every planned reboot.
+ */
+
+#ifndef __APP_TOTALS_H__
+#define __APP_TOTALS_H__
+
+#include <stdint.h>
+
+#ifdef CONFIG_APP_TOTALS_CHECKPOINT
+
+void app_totals_start(void);
+void app_totals_request_checkpoint(void);
+int app_totals_checkpoint_now(void);
+uint32_t app_totals_seq(void);
+void app_totals_set_seq(uint32_t seq);
+
+#else /* CONFIG_APP_TOTALS_CHECKPOINT */
+
+static inline void app_totals_start(void)
+{
+}
+
+static inline void app_totals_request_checkpoint(void)
+{
+}
+
+static inline int app_totals_checkpoint_now(void)
+{
+	return 0;
+}
+
+static inline uint32_t app_totals_seq(void)
+{
+	return 0;
+}
+
+static inline void app_totals_set_seq(uint32_t seq)
+{
+}
+
+#endif /* CONFIG_APP_TOTALS_CHECKPOINT */
+
+#endif /* __APP_TOTALS_H__ */
@@ -1,200 +1,605 @@
 /*
- * Copyright (c) 2022-2023 Golioth, Inc.
+ * Copyright (c) 2022-2025 Golioth, Inc.
  *
  * SPDX-License-Identifier: Apache-2.0
  */
-#include <stdlib.h>
-#include <stdio.h>
+#include <string.h>
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(app_dfu, LOG_LEVEL_DBG);
 
 #include <zephyr/logging/log_ctrl.h>
+#include <zephyr/settings/settings.h>
 #include <zephyr/sys/reboot.h>
 
-#include <net/golioth/fw.h>
-#include <net/golioth/system_client.h>
+#include <golioth/client.h>
+#include <golioth/ota.h>
+#include <golioth/stream.h>
+#include <psa/crypto.h>
+#include <zcbor_encode.h>
 
+#include "../app_totals.h"
+#include "app_dfu.h"
 #include "flash.h"
 
 #define REBOOT_DELAY_SEC 1
 
-K_SEM_DEFINE(sem_downloading, 0, 1);
-K_SEM_DEFINE(sem_downloaded, 0, 1);
+#define DFU_PACKAGE          "main"
+#define DFU_BLOCK_TIMEOUT_S  30
+#define DFU_REPORT_TIMEOUT_S 10
+
+#define DFU_SETTINGS_TREE     "dfu"
+#define DFU_SETTINGS_TARGET   "target"
+#define DFU_SETTINGS_PROGRESS "progress"
+#define DFU_TARGET_KEY        DFU_SETTINGS_TREE "/" DFU_SETTINGS_TARGET
+#define DFU_PROGRESS_KEY      DFU_SETTINGS_TREE "/" DFU_SETTINGS_PROGRESS
+
+#define DFU_STREAM_ENDP     "dfu"
+
+#define DFU_VERSION_MAX_LEN 64
+
+/* Worst case encoded stats: map header, the seven keys (70 bytes), the
+ * version string with a two byte header, then an int32 and five uint32
+ */
+#define DFU_STATS_CBOR_MAX (1 + 70 + (2 + DFU_VERSION_MAX_LEN) + (6 * 5))
+
+#define DFU_BUFS 2
+
+#define DFU_HASH_LEN 32
 
 #define DFU_STACK 2048
-extern void dfu_thread(void *d0, void *d1, void *d2);
+static void dfu_thread(void *d0, void *d1, void *d2);
 K_THREAD_DEFINE(dfu_tid, DFU_STACK, dfu_thread, NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO,
-		0, 0);
+		0, SYS_FOREVER_MS);
+
+/* Above the DFU thread, so a received block is programmed right away */
+static void writer_thread(void *d0, void *d1, void *d2);
+K_THREAD_DEFINE(writer_tid, CONFIG_APP_DFU_WRITER_STACK_SIZE, writer_thread, NULL, NULL, NULL,
+		K_LOWEST_APPLICATION_THREAD_PRIO - 1, 0, SYS_FOREVER_MS);
+
+K_SEM_DEFINE(sem_desired, 0, 1);
+K_SEM_DEFINE(sem_connected, 0, 1);
 
 static struct golioth_client *client;
+static const char *current_version;
+
+/* The release being downloaded, checkpointed with the flash progress */
+struct dfu_target {
+	char version[DFU_VERSION_MAX_LEN + 1];
+	int32_t size;
+	/* SHA-256 of the whole image from the release manifest */
+	uint8_t hash[DFU_HASH_LEN];
+};
+
+struct dfu_stats {
+	int64_t start_ms;
+	uint32_t bytes;
+	/* The DFU thread waited for the writer to free a buffer */
+	uint32_t flash_stall_ms;
+	/* The writer waited for the next block with nothing to program */
+	uint32_t net_stall_ms;
+};
 
 struct dfu_ctx {
 	struct flash_img_context flash;
-	char version[65];
-	bool downloading_started;
+	struct dfu_target target;
+	/* Flushed offset of the last progress checkpoint, writer only */
+	size_t checkpoint;
+	/* Every byte handed to flash so far, writer only once started */
+	psa_hash_operation_t hash_op;
+	struct dfu_stats stats;
+	/* Set from a new release until the download ends either way */
+	atomic_t busy;
+};
+
+/* A received block on its way to the writer */
+struct dfu_block {
+	uint8_t *buf;
+	const uint8_t *data;
+	size_t len;
+	bool is_last;
+	/* No net stall is counted before the first block of a download */
+	bool first;
 };
 
 static struct dfu_ctx update_ctx;
-static enum golioth_dfu_result dfu_initial_result = GOLIOTH_DFU_RESULT_INITIAL;
+static struct dfu_target saved_target;
+static enum golioth_ota_reason dfu_initial_reason = GOLIOTH_OTA_REASON_READY;
+
+static struct golioth_ota_manifest manifest;
+
+BUILD_ASSERT(sizeof(((struct golioth_ota_component *)0)->hash) == DFU_HASH_LEN,
+	     "Release manifest hash is not a binary SHA-256");
+
+/* One block is programmed while the next is received */
+static uint8_t block_bufs[DFU_BUFS][GOLIOTH_OTA_BLOCKSIZE];
+K_MSGQ_DEFINE(free_msgq, sizeof(uint8_t *), DFU_BUFS, sizeof(void *));
+/* One extra slot for the empty last block that ends an aborted download */
+K_MSGQ_DEFINE(filled_msgq, sizeof(struct dfu_block), DFU_BUFS + 1, sizeof(void *));
+K_SEM_DEFINE(sem_written, 0, 1);
+static atomic_t write_err;
 
-extern void dfu_thread(void *d0, void *d1, void *d2)
+static int dfu_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
 {
-	int err;
+	const char *next_name;
+	ssize_t rc;
 
-	k_sem_take(&sem_downloading, K_FOREVER);
+	/* The flash progress under the same tree is loaded by the stream */
+	if (settings_name_steq(name, DFU_SETTINGS_PROGRESS, &next_name) && !next_name) {
+		return 0;
+	}
 
-	err = golioth_fw_report_state(client, "main", current_version_str, update_ctx.version,
-				      GOLIOTH_FW_STATE_DOWNLOADING, GOLIOTH_DFU_RESULT_INITIAL);
-	if (err) {
-		LOG_ERR("Failed to update to '%s' state: %d", "downloading", err);
+	if (!settings_name_steq(name, DFU_SETTINGS_TARGET, &next_name) || next_name) {
+		return -ENOENT;
 	}
 
-	k_sem_take(&sem_downloaded, K_FOREVER);
+	if (len != sizeof(saved_target)) {
+		LOG_WRN("Ignoring download checkpoint of %zu bytes", len);
+		return 0;
+	}
 
-	err = golioth_fw_report_state(client, "main", current_version_str, update_ctx.version,
-				      GOLIOTH_FW_STATE_DOWNLOADED, GOLIOTH_DFU_RESULT_INITIAL);
-	if (err) {
-		LOG_ERR("Failed to update to '%s' state: %d", "downloaded", err);
+	rc = read_cb(cb_arg, &saved_target, sizeof(saved_target));
+	if (rc != sizeof(saved_target)) {
+		saved_target = (struct dfu_target){0};
+		return (rc < 0) ? rc : -EIO;
 	}
 
-	err = golioth_fw_report_state(client, "main", current_version_str, update_ctx.version,
-				      GOLIOTH_FW_STATE_UPDATING, GOLIOTH_DFU_RESULT_INITIAL);
-	if (err) {
-		LOG_ERR("Failed to update to '%s' state: %d", "updating", err);
+	saved_target.version[sizeof(saved_target.version) - 1] = '\0';
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_dfu, DFU_SETTINGS_TREE, NULL, dfu_settings_set, NULL, NULL);
+
+static void report_state(enum golioth_ota_state state, enum golioth_ota_reason reason,
+			 const char *target_version)
+{
+	enum golioth_status status;
+
+	status = golioth_ota_report_state_sync(client, state, reason, DFU_PACKAGE,
+					       current_version, target_version,
+					       DFU_REPORT_TIMEOUT_S);
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Failed to report firmware state %d: %d", state, status);
 	}
+}
 
-	LOG_INF("Requesting upgrade");
+static void wait_for_connection(void)
+{
+	while (!golioth_client_is_connected(client)) {
+		k_sem_take(&sem_connected, K_SECONDS(CONFIG_APP_DFU_RETRY_DELAY_S));
+	}
+}
 
-	err = boot_request_upgrade(BOOT_UPGRADE_TEST);
-	if (err) {
-		LOG_ERR("Failed to request upgrade: %d", err);
+/* Streamed to DFU_STREAM_ENDP when a download ends */
+static void report_stats(struct dfu_ctx *dfu, int err)
+{
+	const struct dfu_stats *st = &dfu->stats;
+	uint32_t duration_ms = MAX(k_uptime_get() - st->start_ms, 1);
+	uint32_t bytes_per_s = ((uint64_t)st->bytes * MSEC_PER_SEC) / duration_ms;
+	uint8_t cbor_buf[DFU_STATS_CBOR_MAX];
+	enum golioth_status status;
+	bool ok;
+
+	LOG_INF("Downloaded %u bytes in %u ms (%u bytes/s), stalled on flash %u ms, "
+		"on the network %u ms", st->bytes, duration_ms, bytes_per_s, st->flash_stall_ms,
+		st->net_stall_ms);
+
+	ZCBOR_STATE_E(zse, 1, cbor_buf, sizeof(cbor_buf), 1);
+
+	ok = zcbor_map_start_encode(zse, 7) &&
+	     zcbor_tstr_put_lit(zse, "version") &&
+	     zcbor_tstr_encode_ptr(zse, dfu->target.version, strlen(dfu->target.version)) &&
+	     zcbor_tstr_put_lit(zse, "err") && zcbor_int32_put(zse, err) &&
+	     zcbor_tstr_put_lit(zse, "bytes") && zcbor_uint32_put(zse, st->bytes) &&
+	     zcbor_tstr_put_lit(zse, "duration_ms") && zcbor_uint32_put(zse, duration_ms) &&
+	     zcbor_tstr_put_lit(zse, "bytes_per_s") && zcbor_uint32_put(zse, bytes_per_s) &&
+	     zcbor_tstr_put_lit(zse, "flash_stall_ms") &&
+	     zcbor_uint32_put(zse, st->flash_stall_ms) &&
+	     zcbor_tstr_put_lit(zse, "net_stall_ms") && zcbor_uint32_put(zse, st->net_stall_ms) &&
+	     zcbor_map_end_encode(zse, 7);
+	if (!ok) {
+		LOG_ERR("Failed to encode download stats: %d", zcbor_peek_error(zse));
 		return;
 	}
 
-	LOG_INF("Rebooting in %d second(s)", REBOOT_DELAY_SEC);
+	status = golioth_stream_set_sync(client, DFU_STREAM_ENDP, GOLIOTH_CONTENT_TYPE_CBOR,
+					 cbor_buf, zse->payload - cbor_buf, DFU_REPORT_TIMEOUT_S);
+	if (status != GOLIOTH_OK) {
+		LOG_WRN("Failed to stream download stats: %d", status);
+	}
+}
 
-	/* Synchronize logs */
-	LOG_PANIC();
+/*
+ * Add what a resumed download already wrote to the hash, read back from
+ * flash. Both block buffers are free before the writer gets any blocks.
+ */
+static int hash_written(struct dfu_ctx *dfu)
+{
+	size_t written = flash_img_bytes_written(&dfu->flash);
+	uint8_t *buf = block_bufs[0];
 
-	k_sleep(K_SECONDS(REBOOT_DELAY_SEC));
+	for (size_t off = 0; off < written; off += GOLIOTH_OTA_BLOCKSIZE) {
+		size_t len = MIN(GOLIOTH_OTA_BLOCKSIZE, written - off);
+		int err = flash_img_read(&dfu->flash, off, buf, len);
 
-	sys_reboot(SYS_REBOOT_COLD);
+		if (err) {
+			return err;
+		}
+
+		if (psa_hash_update(&dfu->hash_op, buf, len) != PSA_SUCCESS) {
+			return -EIO;
+		}
+	}
+
+	return 0;
 }
 
-static int data_received(struct golioth_req_rsp *rsp)
+/*
+ * Continue from the flash progress if it belongs to this release, otherwise
+ * start over and record the new release. Returns the offset to resume at.
+ */
+static int start_download(struct dfu_ctx *dfu)
 {
-	struct dfu_ctx *dfu = rsp->user_data;
-	bool last = rsp->get_next == NULL;
+	const struct dfu_target *t = &dfu->target;
 	int err;
 
-	if (rsp->err) {
-		LOG_ERR("Error while receiving FW data: %d", rsp->err);
-		return 0;
+	dfu->hash_op = psa_hash_operation_init();
+	if (psa_hash_setup(&dfu->hash_op, PSA_ALG_SHA_256) != PSA_SUCCESS) {
+		return -EIO;
 	}
 
-	LOG_DBG("Received %zu bytes at offset %zu%s", rsp->len, rsp->off, last ? " (last)" : "");
+	if ((saved_target.size == t->size) && (strcmp(saved_target.version, t->version) == 0) &&
+	    (memcmp(saved_target.hash, t->hash, sizeof(t->hash)) == 0)) {
+		err = flash_img_resume(&dfu->flash, DFU_PROGRESS_KEY);
+		if (err == 0) {
+			err = hash_written(dfu);
+		}
+		if (err == 0) {
+			size_t offset = flash_img_bytes_written(&dfu->flash);
 
-	if (rsp->off == 0) {
-		err = flash_img_prepare(&dfu->flash);
-		if (err) {
-			return err;
+			LOG_INF("Resuming %s at %zu of %d bytes", t->version, offset, t->size);
+			return offset;
+		}
+
+		LOG_WRN("Failed to resume, starting over: %d", err);
+		psa_hash_abort(&dfu->hash_op);
+		if (psa_hash_setup(&dfu->hash_op, PSA_ALG_SHA_256) != PSA_SUCCESS) {
+			return -EIO;
 		}
 	}
 
-	err = flash_img_buffered_write(&dfu->flash, rsp->data, rsp->len, last);
+	err = flash_img_prepare(&dfu->flash);
 	if (err) {
-		LOG_ERR("Failed to write to flash: %d", err);
 		return err;
 	}
 
-	if (last) {
-		k_sem_give(&sem_downloaded);
+	err = flash_img_progress_clear(&dfu->flash, DFU_PROGRESS_KEY);
+	if (err) {
+		LOG_WRN("Failed to clear download progress: %d", err);
 	}
 
-	if (rsp->get_next) {
-		rsp->get_next(rsp->get_next_data, 0);
+	err = settings_save_one(DFU_TARGET_KEY, t, sizeof(*t));
+	if (err) {
+		LOG_WRN("Failed to save download target, it will not resume: %d", err);
+	} else {
+		saved_target = *t;
 	}
 
 	return 0;
 }
 
-static uint8_t *uri_strip_leading_slash(uint8_t *uri, size_t *uri_len)
+static void write_block(struct dfu_ctx *dfu, const struct dfu_block *blk)
+{
+	int err;
+
+	err = flash_img_buffered_write(&dfu->flash, blk->data, blk->len, blk->is_last);
+	if (err) {
+		LOG_ERR("Failed to write to flash: %d", err);
+		atomic_set(&write_err, err);
+		return;
+	}
+
+	if (psa_hash_update(&dfu->hash_op, blk->data, blk->len) != PSA_SUCCESS) {
+		atomic_set(&write_err, -EIO);
+		return;
+	}
+
+	if (blk->is_last) {
+		return;
+	}
+
+	if ((flash_img_bytes_written(&dfu->flash) - dfu->checkpoint) >=
+	    CONFIG_APP_DFU_CHECKPOINT_BYTES) {
+		dfu->checkpoint = flash_img_bytes_written(&dfu->flash);
+
+		err = flash_img_progress_save(&dfu->flash, DFU_PROGRESS_KEY);
+		if (err) {
+			LOG_WRN("Failed to checkpoint download progress: %d", err);
+		}
+	}
+}
+
+/*
+ * Programs blocks while the DFU thread fetches the next one. After a write
+ * error the remaining blocks are only handed back, so the DFU thread never
+ * waits for a buffer that will not come.
+ */
+static void writer_thread(void *d0, void *d1, void *d2)
+{
+	struct dfu_ctx *dfu = &update_ctx;
+	struct dfu_block blk;
+
+	while (true) {
+		int64_t wait_start = k_uptime_get();
+
+		k_msgq_get(&filled_msgq, &blk, K_FOREVER);
+
+		if (!blk.first) {
+			dfu->stats.net_stall_ms += k_uptime_get() - wait_start;
+		}
+
+		if (blk.data) {
+			if (!atomic_get(&write_err)) {
+				write_block(dfu, &blk);
+			}
+
+			k_msgq_put(&free_msgq, &blk.buf, K_NO_WAIT);
+		}
+
+		if (blk.is_last) {
+			k_sem_give(&sem_written);
+		}
+	}
+}
+
+static int download(struct dfu_ctx *dfu)
 {
-	if (*uri_len > 0 && uri[0] == '/') {
-		(*uri_len)--;
-		return &uri[1];
+	const struct dfu_target *t = &dfu->target;
+	size_t nblocks = golioth_ota_size_to_nblocks(t->size);
+	struct dfu_block blk = {.first = true};
+	size_t first_block;
+	size_t offset;
+	int ret;
+
+	ret = start_download(dfu);
+	if (ret < 0) {
+		psa_hash_abort(&dfu->hash_op);
+		return ret;
 	}
 
-	return uri;
+	offset = ret;
+	first_block = offset / GOLIOTH_OTA_BLOCKSIZE;
+	dfu->checkpoint = offset;
+	dfu->stats = (struct dfu_stats){.start_ms = k_uptime_get()};
+	atomic_clear(&write_err);
+
+	for (size_t block = first_block; block < nblocks; block++) {
+		/* A resumed download can start part way into a block */
+		size_t skip = (block == first_block) ? (offset % GOLIOTH_OTA_BLOCKSIZE) : 0;
+		int64_t wait_start = k_uptime_get();
+		size_t block_nbytes;
+		bool is_last = false;
+		enum golioth_status status;
+		int attempts = 0;
+
+		if (atomic_get(&write_err)) {
+			break;
+		}
+
+		/* Both buffers are still waiting for flash: flash is the bottleneck */
+		k_msgq_get(&free_msgq, &blk.buf, K_FOREVER);
+		dfu->stats.flash_stall_ms += k_uptime_get() - wait_start;
+
+		/* Dropped connections are retried from this block, not the start */
+		while (true) {
+			wait_for_connection();
+
+			block_nbytes = GOLIOTH_OTA_BLOCKSIZE;
+			status = golioth_ota_get_block_sync(client, DFU_PACKAGE, t->version, block,
+							    blk.buf, &block_nbytes, &is_last,
+							    DFU_BLOCK_TIMEOUT_S);
+			if (status == GOLIOTH_OK) {
+				break;
+			}
+
+			/* An error response, e.g. a withdrawn release, will not go away */
+			if ((status == GOLIOTH_ERR_COAP_RESPONSE) ||
+			    (++attempts >= CONFIG_APP_DFU_BLOCK_ATTEMPTS)) {
+				break;
+			}
+
+			LOG_WRN("Failed to get block %zu of %zu: %d, retrying", block, nblocks,
+				status);
+			k_sleep(K_SECONDS(CONFIG_APP_DFU_RETRY_DELAY_S));
+		}
+
+		if (status != GOLIOTH_OK) {
+			LOG_ERR("Failed to get block %zu of %zu: %d, giving up", block, nblocks,
+				status);
+			k_msgq_put(&free_msgq, &blk.buf, K_NO_WAIT);
+			atomic_set(&write_err, -EIO);
+			break;
+		}
+
+		if (skip > block_nbytes) {
+			LOG_ERR("Block %zu is shorter than the resume offset", block);
+			k_msgq_put(&free_msgq, &blk.buf, K_NO_WAIT);
+			atomic_set(&write_err, -EIO);
+			break;
+		}
+
+		LOG_DBG("Received %zu bytes of block %zu%s", block_nbytes, block,
+			is_last ? " (last)" : "");
+
+		blk.data = &blk.buf[skip];
+		blk.len = block_nbytes - skip;
+		blk.is_last = is_last || (block == (nblocks - 1));
+		dfu->stats.bytes += blk.len;
+
+		k_msgq_put(&filled_msgq, &blk, K_FOREVER);
+		blk.first = false;
+
+		if (blk.is_last) {
+			break;
+		}
+	}
+
+	/* Stopped early: an empty last block tells the writer to finish up */
+	if (!blk.is_last) {
+		blk = (struct dfu_block){.is_last = true, .first = true};
+		k_msgq_put(&filled_msgq, &blk, K_FOREVER);
+	}
+
+	k_sem_take(&sem_written, K_FOREVER);
+
+	ret = atomic_get(&write_err);
+	if (ret) {
+		psa_hash_abort(&dfu->hash_op);
+		report_stats(dfu, ret);
+		return ret;
+	}
+
+	/* Verified before the reboot, not by MCUboot after it */
+	if (psa_hash_verify(&dfu->hash_op, t->hash, sizeof(t->hash)) != PSA_SUCCESS) {
+		LOG_ERR("SHA-256 of %s does not match the release", t->version);
+		psa_hash_abort(&dfu->hash_op);
+		ret = -EBADMSG;
+	}
+
+	report_stats(dfu, ret);
+
+	/* Complete or corrupt: either way never resume into this image */
+	flash_img_progress_clear(&dfu->flash, DFU_PROGRESS_KEY);
+	settings_delete(DFU_TARGET_KEY);
+	saved_target = (struct dfu_target){0};
+
+	return ret;
 }
 
-static int golioth_desired_update(struct golioth_req_rsp *rsp)
+static void dfu_thread(void *d0, void *d1, void *d2)
 {
-	struct dfu_ctx *dfu = rsp->user_data;
-	size_t version_len = sizeof(dfu->version) - 1;
-	uint8_t uri[64];
-	uint8_t *uri_p;
-	size_t uri_len = sizeof(uri);
+	struct dfu_ctx *dfu = &update_ctx;
 	int err;
 
-	if (rsp->err) {
-		LOG_ERR("Error while receiving desired FW update: %d", rsp->err);
-		return 0;
+	wait_for_connection();
+	report_state(GOLIOTH_OTA_STATE_IDLE, dfu_initial_reason, NULL);
+
+	while (true) {
+		k_sem_take(&sem_desired, K_FOREVER);
+
+		report_state(GOLIOTH_OTA_STATE_DOWNLOADING, GOLIOTH_OTA_REASON_READY,
+			     dfu->target.version);
+
+		err = download(dfu);
+		if (err) {
+			/* Unless the image was corrupt, the next attempt resumes */
+			LOG_ERR("Firmware download failed: %d", err);
+			report_state(GOLIOTH_OTA_STATE_IDLE,
+				     (err == -EBADMSG) ?
+				     GOLIOTH_OTA_REASON_INTEGRITY_CHECK_FAILURE :
+				     GOLIOTH_OTA_REASON_FIRMWARE_UPDATE_FAILED,
+				     dfu->target.version);
+			atomic_clear(&dfu->busy);
+			continue;
+		}
+
+		report_state(GOLIOTH_OTA_STATE_DOWNLOADED, GOLIOTH_OTA_REASON_READY,
+			     dfu->target.version);
+		report_state(GOLIOTH_OTA_STATE_UPDATING, GOLIOTH_OTA_REASON_READY,
+			     dfu->target.version);
+
+		LOG_INF("Requesting upgrade");
+
+		err = boot_request_upgrade(BOOT_UPGRADE_TEST);
+		if (err) {
+			LOG_ERR("Failed to request upgrade: %d", err);
+			atomic_clear(&dfu->busy);
+			continue;
+		}
+
+		LOG_INF("Rebooting in %d second(s)", REBOOT_DELAY_SEC);
+
+		/* Keep the totals accumulated since the last periodic checkpoint */
+		app_totals_checkpoint_now();
+
+		/* Synchronize logs */
+		LOG_PANIC();
+
+		k_sleep(K_SECONDS(REBOOT_DELAY_SEC));
+
+		sys_reboot(SYS_REBOOT_COLD);
 	}
+}
 
-	LOG_HEXDUMP_DBG(rsp->data, rsp->len, "Desired");
+static void on_ota_manifest(struct golioth_client *client, enum golioth_status status,
+			    const struct golioth_coap_rsp_code *coap_rsp_code, const char *path,
+			    const uint8_t *payload, size_t payload_size, void *arg)
+{
+	struct dfu_ctx *dfu = arg;
+	const struct golioth_ota_component *component;
+
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Error while receiving desired FW update: %d", status);
+		return;
+	}
 
 	/*
 	 * Make sure that we don't start new firmware download and don't overwrite desired version
-	 * which is accessed by main thread.
+	 * which is accessed by the DFU thread.
 	 */
-	if (dfu->downloading_started) {
+	if (atomic_get(&dfu->busy)) {
 		LOG_WRN("Ignoring new desired firmware, as downloading already started");
-		return 0;
+		return;
 	}
 
-	err = golioth_fw_desired_parse(rsp->data, rsp->len, dfu->version, &version_len, uri,
-				       &uri_len);
-	switch (err) {
-	case 0:
-		break;
-	case -ENOENT:
-		LOG_INF("No release rolled out yet");
-		return 0;
-	default:
-		LOG_ERR("Failed to parse desired version: %d", err);
-		return err;
+	status = golioth_ota_payload_as_manifest(payload, payload_size, &manifest);
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Failed to parse desired version: %d", status);
+		return;
 	}
 
-	dfu->version[version_len] = '\0';
+	component = golioth_ota_find_component(&manifest, DFU_PACKAGE);
+	if (!component) {
+		LOG_INF("No release rolled out yet");
+		return;
+	}
 
-	if (version_len == strlen(current_version_str) &&
-	    !strncmp(current_version_str, dfu->version, version_len)) {
-		LOG_INF("Desired version (%s) matches current firmware version!",
-			current_version_str);
-		return -EALREADY;
+	if (strcmp(component->version, current_version) == 0) {
+		LOG_INF("Desired version (%s) matches current firmware version!", current_version);
+		return;
 	}
 
-	uri_p = uri_strip_leading_slash(uri, &uri_len);
+	if (strlen(component->version) >= sizeof(dfu->target.version)) {
+		LOG_ERR("Desired version is too long");
+		return;
+	}
 
-	k_sem_give(&sem_downloading);
-	dfu->downloading_started = true;
+	strcpy(dfu->target.version, component->version);
+	dfu->target.size = component->size;
+	memcpy(dfu->target.hash, component->hash, sizeof(dfu->target.hash));
 
-	err = golioth_fw_download(client, uri_p, uri_len, data_received, dfu);
-	if (err) {
-		LOG_ERR("Failed to request firmware: %d", err);
-		return err;
-	}
+	atomic_set(&dfu->busy, 1);
+	k_sem_give(&sem_desired);
+}
 
-	return 0;
+void app_dfu_on_connect(void)
+{
+	k_sem_give(&sem_connected);
 }
 
-void app_dfu_init(struct golioth_client *dfu_client)
+void app_dfu_init(struct golioth_client *dfu_client, const char *version)
 {
+	enum golioth_status status;
 	int err;
 
 	client = dfu_client;
+	current_version = version;
+
+	if (psa_crypto_init() != PSA_SUCCESS) {
+		LOG_ERR("Failed to initialize PSA crypto");
+		return;
+	}
 
 	if (!boot_is_img_confirmed()) {
 		/*
@@ -203,28 +608,25 @@ void app_dfu_init(struct golioth_client *dfu_client)
 		 * an indication whether previous update process was successful
 		 * or not.
 		 */
-		dfu_initial_result = GOLIOTH_DFU_RESULT_FIRMWARE_UPDATED_SUCCESSFULLY;
+		dfu_initial_reason = GOLIOTH_OTA_REASON_FIRMWARE_UPDATED_SUCCESSFULLY;
 
 		err = boot_write_img_confirmed();
 		if (err) {
 			LOG_ERR("Failed to confirm image: %d", err);
 		}
 	}
-}
 
-void app_dfu_observe(void)
-{
-	int err = golioth_fw_observe_desired(client, golioth_desired_update, &update_ctx);
-	if (err) {
-		LOG_ERR("Failed to start observation of desired FW: %d", err);
+	for (int i = 0; i < DFU_BUFS; i++) {
+		uint8_t *buf = block_bufs[i];
+
+		k_msgq_put(&free_msgq, &buf, K_NO_WAIT);
 	}
-}
 
-void app_dfu_report_state_to_golioth(void)
-{
-	int err = golioth_fw_report_state_cb(client, "main", current_version_str, NULL,
-					     GOLIOTH_FW_STATE_IDLE, dfu_initial_result, NULL, NULL);
-	if (err) {
-		LOG_ERR("Failed to report firmware state: %d", err);
+	k_thread_start(writer_tid);
+	k_thread_start(dfu_tid);
+
+	status = golioth_ota_observe_manifest_async(client, on_ota_manifest, &update_ctx);
+	if (status != GOLIOTH_OK) {
+		LOG_ERR("Failed to start observation of desired FW: %d", status);
 	}
 }
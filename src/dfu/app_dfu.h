@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021-2023 Golioth, Inc.
+ * Copyright (c) 2021-2025 Golioth, Inc.
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -7,10 +7,23 @@
 #ifndef __APP_DFU_H__
 #define __APP_DFU_H__
 
-#include <net/golioth/system_client.h>
+#include <golioth/client.h>
 
-void app_dfu_init(struct golioth_client *client);
-void app_dfu_observe(void);
-void app_dfu_report_state_to_golioth(void);
+#ifdef CONFIG_APP_DFU
+
+void app_dfu_init(struct golioth_client *client, const char *version);
+void app_dfu_on_connect(void);
+
+#else /* CONFIG_APP_DFU */
+
+static inline void app_dfu_init(struct golioth_client *client, const char *version)
+{
+}
+
+static inline void app_dfu_on_connect(void)
+{
+}
+
+#endif /* CONFIG_APP_DFU */
 
 #endif /* __APP_DFU_H__ */
@@ -7,96 +7,50 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(golioth_dfu, LOG_LEVEL_DBG);
 
-#include <stdio.h>
 #include <zephyr/storage/flash_map.h>
 
 #include "flash.h"
 
-#ifdef CONFIG_TRUSTED_EXECUTION_NONSECURE
-#define SLOT0_LABEL	slot0_ns_partition
-#else
-#define SLOT0_LABEL	slot0_partition
-#endif /* CONFIG_TRUSTED_EXECUTION_NONSECURE */
-
-/* FIXED_PARTITION_ID() values used below are auto-generated by DT */
-#define FLASH_AREA_IMAGE_PRIMARY FIXED_PARTITION_ID(SLOT0_LABEL)
-
-char current_version_str[sizeof("255.255.65535")];
-
-static int current_version_init(void)
-{
-	struct mcuboot_img_header hdr;
-	int written;
-	int err;
-
-	err = boot_read_bank_header(FLASH_AREA_IMAGE_PRIMARY, &hdr, sizeof(hdr));
-	if (err) {
-		LOG_ERR("Failed to read primary area (%u) header: %d",
-			FLASH_AREA_IMAGE_PRIMARY, err);
-		return err;
-	}
-
-	written = snprintf(current_version_str, sizeof(current_version_str),
-			   "%u.%u.%u",
-			   (unsigned int) hdr.h.v1.sem_ver.major,
-			   (unsigned int) hdr.h.v1.sem_ver.minor,
-			   (unsigned int) hdr.h.v1.sem_ver.revision);
-	if (written >= sizeof(current_version_str)) {
-		LOG_ERR("Version string is too long!");
-		current_version_str[0] = '\0';
-		return -ENOMEM;
-	}
-
-	return 0;
-}
-
-SYS_INIT(current_version_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
-
 /*
  * @note This is a copy of ERASED_VAL_32() from mcumgr.
  */
 #define ERASED_VAL_32(x) (((x) << 24) | ((x) << 16) | ((x) << 8) | (x))
 
+/*
+ * Large enough that scanning an erased slot takes few reads, so only used
+ * by the DFU thread.
+ */
+#define CHECK_EMPTY_CHUNK 1024
+
 /**
  * Determines if the specified area of flash is completely unwritten.
  *
- * @note This is a copy of zephyr_img_mgmt_flash_check_empty() from mcumgr.
+ * Reads a kilobyte at a time instead of 64 bytes and stops at the first
+ * written word, so an erased slot takes a sixteenth of the reads.
  */
 static int flash_area_check_empty(const struct flash_area *fa,
 				  bool *out_empty)
 {
-	uint32_t data[16];
+	static uint32_t data[CHECK_EMPTY_CHUNK / sizeof(uint32_t)];
+	uint32_t erased_val_32;
 	off_t addr;
-	off_t end;
-	int bytes_to_read;
 	int rc;
-	int i;
-	uint8_t erased_val;
-	uint32_t erased_val_32;
 
 	__ASSERT_NO_MSG(fa->fa_size % 4 == 0);
 
-	erased_val = flash_area_erased_val(fa);
-	erased_val_32 = ERASED_VAL_32(erased_val);
+	erased_val_32 = ERASED_VAL_32((uint32_t)flash_area_erased_val(fa));
 
-	end = fa->fa_size;
-	for (addr = 0; addr < end; addr += sizeof(data)) {
-		if (end - addr < sizeof(data)) {
-			bytes_to_read = end - addr;
-		} else {
-			bytes_to_read = sizeof(data);
-		}
+	for (addr = 0; addr < fa->fa_size; addr += sizeof(data)) {
+		size_t bytes_to_read = MIN(sizeof(data), fa->fa_size - addr);
 
 		rc = flash_area_read(fa, addr, data, bytes_to_read);
 		if (rc != 0) {
-			flash_area_close(fa);
 			return rc;
 		}
 
-		for (i = 0; i < bytes_to_read / 4; i++) {
+		for (size_t i = 0; i < bytes_to_read / sizeof(uint32_t); i++) {
 			if (data[i] != erased_val_32) {
 				*out_empty = false;
-				flash_area_close(fa);
 				return 0;
 			}
 		}
@@ -151,12 +105,10 @@ static const char *swap_type_str(int swap_type)
 	return "unknown";
 }
 
-int flash_img_prepare(struct flash_img_context *flash)
+static int flash_img_check_swap_type(void)
 {
-	int swap_type;
-	int err;
+	int swap_type = mcuboot_swap_type();
 
-	swap_type = mcuboot_swap_type();
 	switch (swap_type) {
 	case BOOT_SWAP_TYPE_REVERT:
 		LOG_WRN("'revert' swap type detected, it is not safe to continue");
@@ -166,6 +118,18 @@ int flash_img_prepare(struct flash_img_context *flash)
 		break;
 	}
 
+	return 0;
+}
+
+int flash_img_prepare(struct flash_img_context *flash)
+{
+	int err;
+
+	err = flash_img_check_swap_type();
+	if (err) {
+		return err;
+	}
+
 	err = flash_img_init(flash);
 	if (err) {
 		LOG_ERR("failed to init: %d", err);
@@ -180,3 +144,47 @@ int flash_img_prepare(struct flash_img_context *flash)
 
 	return 0;
 }
+
+int flash_img_resume(struct flash_img_context *flash, const char *progress_key)
+{
+	int err;
+
+	err = flash_img_check_swap_type();
+	if (err) {
+		return err;
+	}
+
+	err = flash_img_init(flash);
+	if (err) {
+		LOG_ERR("failed to init: %d", err);
+		return err;
+	}
+
+	/*
+	 * Nothing is erased: the progress restores the write offset, and the
+	 * page it ends in is marked erased so progressive erase keeps it.
+	 */
+	err = stream_flash_progress_load(&flash->stream, progress_key);
+	if (err) {
+		LOG_ERR("failed to load progress: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+/* Only bytes already flushed to flash are recorded */
+int flash_img_progress_save(struct flash_img_context *flash, const char *progress_key)
+{
+	return stream_flash_progress_save(&flash->stream, progress_key);
+}
+
+int flash_img_progress_clear(struct flash_img_context *flash, const char *progress_key)
+{
+	return stream_flash_progress_clear(&flash->stream, progress_key);
+}
+
+int flash_img_read(struct flash_img_context *flash, off_t off, void *dst, size_t len)
+{
+	return flash_area_read(flash->flash_area, off, dst, len);
+}
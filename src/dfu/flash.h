@@ -14,14 +14,18 @@
 #include <zephyr/types.h>
 
 int flash_img_prepare(struct flash_img_context *flash);
-
-extern char current_version_str[sizeof("255.255.65535")];
+int flash_img_resume(struct flash_img_context *flash, const char *progress_key);
+int flash_img_progress_save(struct flash_img_context *flash, const char *progress_key);
+int flash_img_progress_clear(struct flash_img_context *flash, const char *progress_key);
+int flash_img_read(struct flash_img_context *flash, off_t off, void *dst, size_t len);
 
 #else /* CONFIG_BOOTLOADER_MCUBOOT */
 
+#include <errno.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/types.h>
 
 struct flash_img_context {
 	/* empty */
@@ -32,6 +36,34 @@ static inline int flash_img_prepare(struct flash_img_context *flash)
 	return 0;
 }
 
+static inline int flash_img_resume(struct flash_img_context *flash, const char *progress_key)
+{
+	return 0;
+}
+
+static inline int flash_img_progress_save(struct flash_img_context *flash,
+					  const char *progress_key)
+{
+	return 0;
+}
+
+static inline int flash_img_progress_clear(struct flash_img_context *flash,
+					   const char *progress_key)
+{
+	return 0;
+}
+
+static inline int flash_img_read(struct flash_img_context *flash, off_t off, void *dst,
+				 size_t len)
+{
+	return -ENOTSUP;
+}
+
+static inline size_t flash_img_bytes_written(struct flash_img_context *ctx)
+{
+	return 0;
+}
+
 static inline
 int flash_img_buffered_write(struct flash_img_context *ctx, const uint8_t *data,
 			     size_t len, bool flush)
@@ -58,8 +90,6 @@ static inline int boot_write_img_confirmed(void)
 	return 0;
 }
 
-static char current_version_str[sizeof("255.255.65535")] = "1.0.0";
-
 #endif /* CONFIG_BOOTLOADER_MCUBOOT */
 
 #endif /* __APP_FLASH_H__ */
@@ -0,0 +1,565 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(golioth_standin, LOG_LEVEL_DBG);
+
+#include <stdlib.h>
+#include <string.h>
+#include <golioth/client.h>
+#include <golioth/lightdb_state.h>
+#include <golioth/rpc.h>
+#include <golioth/settings.h>
+#include <golioth/stream.h>
+#include <samples/common/net_connect.h>
+#include <zcbor_decode.h>
+#include <zcbor_encode.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "golioth_standin.h"
+
+#define STANDIN_QUEUE_LEN    16
+#define STANDIN_MAX_RPCS     16
+/* Same limit as the SDK, so native_sim fails where hardware would */
+#define STANDIN_MAX_SETTINGS CONFIG_GOLIOTH_MAX_NUM_SETTINGS
+#define STANDIN_PATH_LEN     32
+#define STANDIN_RPC_REQ_LEN  128
+
+/* 0xf6 is `null` in CBOR, returned for paths that were never written */
+static const uint8_t cbor_null = 0xf6;
+
+enum standin_req_type {
+	REQ_EVENT,
+	REQ_SET,
+	REQ_GET,
+};
+
+struct standin_req {
+	enum standin_req_type type;
+	const char *path;
+	union {
+		golioth_set_cb_fn set_cb;
+		golioth_get_cb_fn get_cb;
+	};
+	void *arg;
+};
+
+/* The handle is never dereferenced, it only has to be unique */
+static uint8_t standin_handle;
+#define STANDIN_CLIENT ((struct golioth_client *)&standin_handle)
+
+K_MSGQ_DEFINE(standin_msgq, sizeof(struct standin_req), STANDIN_QUEUE_LEN, 4);
+static K_MUTEX_DEFINE(standin_lock);
+
+static atomic_t connected;
+static golioth_client_event_cb_fn event_cb;
+static void *event_cb_arg;
+static struct golioth_standin_stats stats;
+
+static struct {
+	char path[STANDIN_PATH_LEN];
+	uint8_t buf[CONFIG_APP_GOLIOTH_STANDIN_STATE_LEN];
+	size_t len;
+} state[CONFIG_APP_GOLIOTH_STANDIN_STATE_PATHS];
+
+static struct {
+	const char *method;
+	golioth_rpc_cb_fn cb;
+	void *arg;
+} rpcs[STANDIN_MAX_RPCS];
+
+static struct {
+	const char *name;
+	int32_t min;
+	int32_t max;
+	golioth_int_setting_cb cb;
+	void *arg;
+} settings[STANDIN_MAX_SETTINGS];
+
+static enum golioth_status standin_post(const struct standin_req *req)
+{
+	if (k_msgq_put(&standin_msgq, req, K_NO_WAIT)) {
+		return GOLIOTH_ERR_QUEUE_FULL;
+	}
+
+	return GOLIOTH_OK;
+}
+
+/* Narrow a stored document down to the value at the remaining path, one
+ * map key per path component.
+ */
+static bool cbor_find_path(const uint8_t **payload, size_t *len, const char *path)
+{
+	while (*path) {
+		const char *end = strchr(path, '/');
+		size_t key_len = end ? (size_t)(end - path) : strlen(path);
+		struct zcbor_string key;
+		bool found = false;
+
+		ZCBOR_STATE_D(zsd, 2, *payload, *len, 1, 0);
+
+		if (!zcbor_map_start_decode(zsd)) {
+			return false;
+		}
+
+		while (!found && (zsd->elem_count > 1)) {
+			if (!zcbor_tstr_decode(zsd, &key)) {
+				return false;
+			}
+
+			if ((key.len == key_len) && (memcmp(key.value, path, key_len) == 0)) {
+				const uint8_t *start = zsd->payload;
+
+				if (!zcbor_any_skip(zsd, NULL)) {
+					return false;
+				}
+
+				*payload = start;
+				*len = zsd->payload - start;
+				found = true;
+			} else if (!zcbor_any_skip(zsd, NULL)) {
+				return false;
+			}
+		}
+
+		if (!found) {
+			return false;
+		}
+
+		path = end ? (end + 1) : (path + key_len);
+	}
+
+	return true;
+}
+
+static void state_get(const struct standin_req *req)
+{
+	const uint8_t *payload = &cbor_null;
+	size_t len = sizeof(cbor_null);
+
+	k_mutex_lock(&standin_lock, K_FOREVER);
+
+	stats.state_gets++;
+
+	for (size_t i = 0; i < ARRAY_SIZE(state); i++) {
+		size_t plen = strlen(state[i].path);
+		const uint8_t *doc = state[i].buf;
+		size_t doc_len = state[i].len;
+
+		if ((plen == 0) || (strncmp(req->path, state[i].path, plen) != 0)) {
+			continue;
+		}
+
+		if (req->path[plen] == '\0') {
+			payload = doc;
+			len = doc_len;
+			break;
+		}
+
+		if ((req->path[plen] == '/') &&
+		    cbor_find_path(&doc, &doc_len, &req->path[plen + 1])) {
+			payload = doc;
+			len = doc_len;
+			break;
+		}
+	}
+
+	/* The callback runs with the lock held so the document cannot change */
+	req->get_cb(STANDIN_CLIENT, GOLIOTH_OK, NULL, req->path, payload, len, req->arg);
+
+	k_mutex_unlock(&standin_lock);
+}
+
+/* Requests in flight when the link drops never get a response */
+static void standin_drop(const struct standin_req *req)
+{
+	k_mutex_lock(&standin_lock, K_FOREVER);
+	stats.dropped++;
+	k_mutex_unlock(&standin_lock);
+
+	if (req->type == REQ_GET) {
+		req->get_cb(STANDIN_CLIENT, GOLIOTH_ERR_TIMEOUT, NULL, req->path, NULL, 0,
+			    req->arg);
+	} else if (req->set_cb) {
+		req->set_cb(STANDIN_CLIENT, GOLIOTH_ERR_TIMEOUT, NULL, req->path, req->arg);
+	}
+}
+
+static void standin_thread(void *p1, void *p2, void *p3)
+{
+	struct standin_req req;
+	enum golioth_client_event event;
+
+	while (true) {
+		k_msgq_get(&standin_msgq, &req, K_FOREVER);
+		k_sleep(K_MSEC(CONFIG_APP_GOLIOTH_STANDIN_LATENCY_MS));
+
+		if (req.type == REQ_EVENT) {
+			event = (enum golioth_client_event)(uintptr_t)req.arg;
+			if (event_cb) {
+				event_cb(STANDIN_CLIENT, event, event_cb_arg);
+			}
+		} else if (!atomic_get(&connected)) {
+			standin_drop(&req);
+		} else if (req.type == REQ_GET) {
+			state_get(&req);
+		} else if (req.set_cb) {
+			req.set_cb(STANDIN_CLIENT, GOLIOTH_OK, NULL, req.path, req.arg);
+		}
+	}
+}
+
+K_THREAD_DEFINE(standin_tid, 2048, standin_thread, NULL, NULL, NULL, K_PRIO_PREEMPT(7), 0, 0);
+
+void golioth_standin_set_connected(bool is_connected)
+{
+	struct standin_req req = {
+		.type = REQ_EVENT,
+		.arg = (void *)(uintptr_t)(is_connected ? GOLIOTH_CLIENT_EVENT_CONNECTED
+						     : GOLIOTH_CLIENT_EVENT_DISCONNECTED),
+	};
+
+	if (atomic_set(&connected, is_connected) == is_connected) {
+		return;
+	}
+
+	LOG_INF("Stand-in %s", is_connected ? "connected" : "disconnected");
+
+	if (standin_post(&req) != GOLIOTH_OK) {
+		LOG_ERR("Stand-in queue full, event lost");
+	}
+}
+
+void golioth_standin_get_stats(struct golioth_standin_stats *out)
+{
+	k_mutex_lock(&standin_lock, K_FOREVER);
+	*out = stats;
+	k_mutex_unlock(&standin_lock);
+}
+
+/*
+ * Golioth SDK calls, redirected with --wrap
+ */
+
+void __wrap_net_connect(void)
+{
+	LOG_INF("Using the local Golioth stand-in, no network needed");
+}
+
+struct golioth_client *__wrap_golioth_client_create(const struct golioth_client_config *config)
+{
+	ARG_UNUSED(config);
+
+	return STANDIN_CLIENT;
+}
+
+void __wrap_golioth_client_register_event_callback(struct golioth_client *client,
+						    golioth_client_event_cb_fn callback,
+						    void *arg)
+{
+	event_cb = callback;
+	event_cb_arg = arg;
+
+	/* Connect once somebody is listening, like the SDK does after DTLS */
+	golioth_standin_set_connected(true);
+}
+
+bool __wrap_golioth_client_is_connected(struct golioth_client *client)
+{
+	return atomic_get(&connected);
+}
+
+enum golioth_status __wrap_golioth_stream_set_async(struct golioth_client *client,
+						    const char *path,
+						    enum golioth_content_type content_type,
+						    const uint8_t *buf, size_t buf_len,
+						    golioth_set_cb_fn callback, void *callback_arg)
+{
+	struct standin_req req = {
+		.type = REQ_SET,
+		.path = path,
+		.set_cb = callback,
+		.arg = callback_arg,
+	};
+
+	k_mutex_lock(&standin_lock, K_FOREVER);
+	stats.stream_msgs++;
+	stats.stream_bytes += buf_len;
+	k_mutex_unlock(&standin_lock);
+
+	LOG_DBG("stream %s: %zu bytes", path, buf_len);
+	LOG_HEXDUMP_DBG(buf, buf_len, path);
+
+	return standin_post(&req);
+}
+
+enum golioth_status __wrap_golioth_lightdb_set_async(struct golioth_client *client,
+						     const char *path,
+						     enum golioth_content_type content_type,
+						     const uint8_t *buf, size_t buf_len,
+						     golioth_set_cb_fn callback,
+						     void *callback_arg)
+{
+	struct standin_req req = {
+		.type = REQ_SET,
+		.path = path,
+		.set_cb = callback,
+		.arg = callback_arg,
+	};
+	size_t slot = ARRAY_SIZE(state);
+
+	if ((buf_len > sizeof(state[0].buf)) || (strlen(path) >= sizeof(state[0].path))) {
+		LOG_ERR("state %s: %zu bytes do not fit the stand-in", path, buf_len);
+		return GOLIOTH_ERR_MEM_ALLOC;
+	}
+
+	k_mutex_lock(&standin_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(state); i++) {
+		if (strcmp(state[i].path, path) == 0) {
+			slot = i;
+			break;
+		}
+
+		if ((slot == ARRAY_SIZE(state)) && (state[i].path[0] == '\0')) {
+			slot = i;
+		}
+	}
+
+	if (slot < ARRAY_SIZE(state)) {
+		strcpy(state[slot].path, path);
+		memcpy(state[slot].buf, buf, buf_len);
+		state[slot].len = buf_len;
+		stats.state_msgs++;
+		stats.state_bytes += buf_len;
+	}
+
+	k_mutex_unlock(&standin_lock);
+
+	if (slot == ARRAY_SIZE(state)) {
+		LOG_ERR("state %s: no free stand-in path", path);
+		return GOLIOTH_ERR_MEM_ALLOC;
+	}
+
+	LOG_DBG("state %s: %zu bytes", path, buf_len);
+	LOG_HEXDUMP_DBG(buf, buf_len, path);
+
+	return standin_post(&req);
+}
+
+enum golioth_status __wrap_golioth_lightdb_get_async(struct golioth_client *client,
+						     const char *path,
+						     enum golioth_content_type content_type,
+						     golioth_get_cb_fn callback,
+						     void *callback_arg)
+{
+	struct standin_req req = {
+		.type = REQ_GET,
+		.path = path,
+		.get_cb = callback,
+		.arg = callback_arg,
+	};
+
+	return standin_post(&req);
+}
+
+struct golioth_rpc *__wrap_golioth_rpc_init(struct golioth_client *client)
+{
+	return (struct golioth_rpc *)rpcs;
+}
+
+enum golioth_status __wrap_golioth_rpc_register(struct golioth_rpc *grpc, const char *method,
+						golioth_rpc_cb_fn callback, void *callback_arg)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(rpcs); i++) {
+		if (!rpcs[i].method) {
+			rpcs[i].method = method;
+			rpcs[i].cb = callback;
+			rpcs[i].arg = callback_arg;
+			return GOLIOTH_OK;
+		}
+	}
+
+	return GOLIOTH_ERR_MEM_ALLOC;
+}
+
+struct golioth_settings *__wrap_golioth_settings_init(struct golioth_client *client)
+{
+	return (struct golioth_settings *)settings;
+}
+
+enum golioth_status __wrap_golioth_settings_register_int_with_range(
+	struct golioth_settings *gsettings, const char *setting_name, int32_t min_val,
+	int32_t max_val, golioth_int_setting_cb callback, void *callback_arg)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(settings); i++) {
+		if (!settings[i].name) {
+			settings[i].name = setting_name;
+			settings[i].min = min_val;
+			settings[i].max = max_val;
+			settings[i].cb = callback;
+			settings[i].arg = callback_arg;
+			return GOLIOTH_OK;
+		}
+	}
+
+	return GOLIOTH_ERR_MEM_ALLOC;
+}
+
+#ifdef CONFIG_SHELL
+
+static bool encode_param(zcbor_state_t *zse, const char *arg)
+{
+	char *end;
+	long val = strtol(arg, &end, 0);
+
+	if ((*arg != '\0') && (*end == '\0')) {
+		return zcbor_int32_put(zse, (int32_t)val);
+	}
+
+	double dval = strtod(arg, &end);
+
+	if ((*arg != '\0') && (*end == '\0')) {
+		return zcbor_float64_put(zse, dval);
+	}
+
+	if ((strcmp(arg, "true") == 0) || (strcmp(arg, "false") == 0)) {
+		return zcbor_bool_put(zse, arg[0] == 't');
+	}
+
+	return zcbor_tstr_encode_ptr(zse, arg, strlen(arg));
+}
+
+static int cmd_rpc(const struct shell *sh, size_t argc, char **argv)
+{
+	static uint8_t req_buf[STANDIN_RPC_REQ_LEN];
+	static uint8_t rsp_buf[CONFIG_GOLIOTH_RPC_MAX_RESPONSE_LEN];
+	enum golioth_rpc_status status;
+	size_t n_params = argc - 2;
+	size_t req_len;
+	bool ok;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(rpcs); i++) {
+		if (rpcs[i].method && (strcmp(rpcs[i].method, argv[1]) == 0)) {
+			break;
+		}
+	}
+
+	if (i == ARRAY_SIZE(rpcs)) {
+		shell_error(sh, "Unknown method %s", argv[1]);
+		return -ENOENT;
+	}
+
+	ZCBOR_STATE_E(req_zse, 1, req_buf, sizeof(req_buf), 1);
+
+	ok = zcbor_list_start_encode(req_zse, n_params);
+	for (size_t p = 0; ok && (p < n_params); p++) {
+		ok = encode_param(req_zse, argv[p + 2]);
+	}
+	ok = ok && zcbor_list_end_encode(req_zse, n_params);
+	if (!ok) {
+		shell_error(sh, "Parameters do not fit %d bytes", STANDIN_RPC_REQ_LEN);
+		return -ENOMEM;
+	}
+
+	req_len = req_zse->payload - req_buf;
+
+	ZCBOR_STATE_D(req_zsd, 2, req_buf, req_len, 1, 0);
+	ZCBOR_STATE_E(rsp_zse, 2, rsp_buf, sizeof(rsp_buf), 1);
+
+	/* The SDK hands the callback an open params list and detail map */
+	zcbor_list_start_decode(req_zsd);
+	zcbor_map_start_encode(rsp_zse, SIZE_MAX);
+
+	status = rpcs[i].cb(req_zsd, rsp_zse, rpcs[i].arg);
+
+	if (!zcbor_map_end_encode(rsp_zse, SIZE_MAX)) {
+		shell_error(sh, "Response does not fit %d bytes",
+			    CONFIG_GOLIOTH_RPC_MAX_RESPONSE_LEN);
+		return -ENOMEM;
+	}
+
+	shell_print(sh, "%s: status %d", argv[1], status);
+	shell_hexdump(sh, rsp_buf, rsp_zse->payload - rsp_buf);
+
+	return 0;
+}
+
+static int cmd_setting(const struct shell *sh, size_t argc, char **argv)
+{
+	enum golioth_settings_status status;
+	char *end;
+	long val = strtol(argv[2], &end, 0);
+
+	if (*end != '\0') {
+		shell_error(sh, "Only integer settings are supported");
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(settings); i++) {
+		if (!settings[i].name || (strcmp(settings[i].name, argv[1]) != 0)) {
+			continue;
+		}
+
+		if ((val < settings[i].min) || (val > settings[i].max)) {
+			shell_error(sh, "%s must be in [%d, %d]", argv[1], settings[i].min,
+				    settings[i].max);
+			return -ERANGE;
+		}
+
+		status = settings[i].cb((int32_t)val, settings[i].arg);
+		shell_print(sh, "%s = %ld: status %d", argv[1], val, status);
+
+		return 0;
+	}
+
+	shell_error(sh, "Unknown setting %s", argv[1]);
+
+	return -ENOENT;
+}
+
+static int cmd_connect(const struct shell *sh, size_t argc, char **argv)
+{
+	golioth_standin_set_connected(true);
+
+	return 0;
+}
+
+static int cmd_disconnect(const struct shell *sh, size_t argc, char **argv)
+{
+	golioth_standin_set_connected(false);
+
+	return 0;
+}
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	struct golioth_standin_stats s;
+
+	golioth_standin_get_stats(&s);
+
+	shell_print(sh, "stream: %u messages, %llu bytes", s.stream_msgs, s.stream_bytes);
+	shell_print(sh, "state: %u writes, %llu bytes, %u reads", s.state_msgs, s.state_bytes,
+		    s.state_gets);
+	shell_print(sh, "dropped: %u", s.dropped);
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+	standin_cmds,
+	SHELL_CMD(connect, NULL, "Report the client as connected", cmd_connect),
+	SHELL_CMD(disconnect, NULL, "Report the client as disconnected", cmd_disconnect),
+	SHELL_CMD_ARG(rpc, NULL, "Call an RPC: <method> [params...]", cmd_rpc, 2, 8),
+	SHELL_CMD_ARG(setting, NULL, "Apply a setting: <name> <value>", cmd_setting, 3, 0),
+	SHELL_CMD(stats, NULL, "Show upload counters", cmd_stats),
+	SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(standin, &standin_cmds, "Local Golioth stand-in", NULL);
+
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Local stand-in for the Golioth cloud on native_sim. The client, stream,
+ * LightDB State, settings and RPC calls the application makes are
+ * redirected here at link time, so the acquisition and reporting path runs
+ * without network access or credentials.
+ *
+ * Uploads are logged and counted, LightDB State writes are kept in RAM and
+ * served back to reads, and settings and RPCs are invoked from the
+ * `standin` shell command.
+ */
+
+#ifndef __GOLIOTH_STANDIN_H__
+#define __GOLIOTH_STANDIN_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct golioth_standin_stats {
+	uint32_t stream_msgs;
+	uint64_t stream_bytes;
+	uint32_t state_msgs;
+	uint64_t state_bytes;
+	uint32_t state_gets;
+	/* Requests completed with an error because the link was down */
+	uint32_t dropped;
+};
+
+/** Report the client as connected or disconnected, as the cloud link would */
+void golioth_standin_set_connected(bool connected);
+
+void golioth_standin_get_stats(struct golioth_standin_stats *stats);
+
+#endif /* __GOLIOTH_STANDIN_H__ */
@@ -8,10 +8,22 @@
 LOG_MODULE_REGISTER(golioth_ac_powermonitor, LOG_LEVEL_DBG);
 
 #include <app_version.h>
+#include "app_batch.h"
+#include "app_bench.h"
+#include "app_capture.h"
+#include "app_display.h"
+#include "app_events.h"
+#include "app_harmonics.h"
+#include "app_log.h"
+#include "app_metrics.h"
+#include "app_power.h"
 #include "app_rpc.h"
 #include "app_settings.h"
 #include "app_state.h"
 #include "app_sensors.h"
+#include "app_sensor_log.h"
+#include "app_totals.h"
+#include "dfu/app_dfu.h"
 #include <golioth/client.h>
 #include <golioth/fw_update.h>
 #include <samples/common/net_connect.h>
@@ -67,6 +79,15 @@ static void on_client_event(struct golioth_client *client, enum golioth_client_e
 	if (is_connected) {
 		k_sem_give(&connected);
 		golioth_connection_led_set(1);
+		app_log_cloud_filter_apply();
+		app_dfu_on_connect();
+
+		/* Send transitions held while offline, then replay stored records */
+		app_events_flush();
+		app_batch_drain_start();
+
+		/* Reconcile the restored totals with state/cumulative */
+		app_work_on_connect();
 	}
 	LOG_INF("Golioth client %s", is_connected ? "connected" : "disconnected");
 }
@@ -83,7 +104,8 @@ static void start_golioth_client(void)
 	golioth_client_register_event_callback(client, on_client_event, NULL);
 
 	/* Initialize DFU components */
-	golioth_fw_update_init(client, _current_version);
+	IF_ENABLED(CONFIG_GOLIOTH_FW_UPDATE, (golioth_fw_update_init(client, _current_version);));
+	app_dfu_init(client, _current_version);
 
 	/*** Call Golioth APIs for other services in dedicated app files ***/
 
@@ -92,6 +114,11 @@ static void start_golioth_client(void)
 
 	/* Set Golioth Client for streaming sensor data */
 	app_sensors_set_client(client);
+	app_batch_set_client(client);
+	app_capture_set_client(client);
+	app_metrics_set_client(client);
+	app_events_set_client(client);
+	app_harmonics_set_client(client);
 
 	/* Register Settings service */
 	app_settings_register(client);
@@ -197,6 +224,20 @@ int main(void)
 	/* Initialize sensors */
 	app_sensors_init();
 
+	/* Recover records stored in flash before the last reset */
+	err = app_sensor_log_init();
+	if (err) {
+		LOG_ERR("Sensor log unavailable, offline records will not persist: %d", err);
+	}
+
+	app_harmonics_start();
+
+	/* Totals were restored from flash when the settings were loaded */
+	app_totals_start();
+
+	app_metrics_start();
+	app_bench_init();
+
 #if DT_NODE_EXISTS(DT_ALIAS(golioth_led))
 	/* Initialize Golioth logo LED */
 	err = gpio_pin_configure_dt(&golioth_led, GPIO_OUTPUT_INACTIVE);
@@ -210,6 +251,9 @@ int main(void)
 	 * Golioth Client will start automatically when LTE connects
 	 */
 
+	/* Request PSM and eDRX before the modem attaches */
+	app_power_init();
+
 	LOG_INF("Connecting to LTE, this may take some time...");
 	lte_lc_connect_async(lte_handler);
 
@@ -246,40 +290,7 @@ int main(void)
 	gpio_init_callback(&button_cb_data, button_pressed, BIT(user_btn.pin));
 	gpio_add_callback(user_btn.port, &button_cb_data);
 
-	IF_ENABLED(CONFIG_LIB_OSTENTUS,(
-		/* Set up a slideshow on Ostentus
-		 *  - add up to 256 slides
-		 *  - use the enum in app_sensors.h to add new keys
-		 *  - values are updated using these keys (see app_sensors.c)
-		 */
-		ostentus_slide_add(o_dev, CH0_CURRENT, CH0_CUR_LABEL, strlen(CH0_CUR_LABEL));
-		ostentus_slide_add(o_dev, CH1_CURRENT, CH1_CUR_LABEL, strlen(CH1_CUR_LABEL));
-
-		ostentus_slide_add(o_dev, CH0_ONTIME, CH0_ONTIME_LBL, strlen(CH0_ONTIME_LBL));
-		ostentus_slide_add(o_dev, CH1_ONTIME, CH1_ONTIME_LBL, strlen(CH1_ONTIME_LBL));
-
-		IF_ENABLED(CONFIG_ALUDEL_BATTERY_MONITOR, (
-			ostentus_slide_add(o_dev,
-					   BATTERY_V,
-					   LABEL_BATTERY,
-					   strlen(LABEL_BATTERY));
-			ostentus_slide_add(o_dev,
-					   BATTERY_PCT,
-					   LABEL_BATTERY,
-					   strlen(LABEL_BATTERY));
-		));
-		ostentus_slide_add(o_dev, FIRMWARE, LABEL_FIRMWARE, strlen(LABEL_FIRMWARE));
-
-		/* Set the title of the Ostentus summary slide (optional) */
-		ostentus_summary_title(o_dev, SUMMARY_TITLE, strlen(SUMMARY_TITLE));
-
-		/* Update the Firmware slide with the firmware version */
-		ostentus_slide_set(o_dev, FIRMWARE, (char *)_current_version,
-			  strlen(_current_version));
-
-		/* Start Ostentus slideshow with 30 second delay between slides */
-		ostentus_slideshow(o_dev, 30000);
-	));
+	app_display_init(_current_version);
 
 	while (true) {
 		app_sensors_read_and_stream();
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Decoder for the 32-clock read frame of the Microchip MCP3201 12-bit ADC.
+ *
+ * After two sample clocks and a null bit, the MCP3201 shifts out the
+ * conversion MSB first (B11..B0), then repeats it LSB first (B1..B11),
+ * sharing B0 between the two. Read as a big-endian 32-bit word:
+ *
+ *   bit 31..30  sampling (undefined)
+ *   bit 29      null bit, must be 0
+ *   bit 28..17  B11..B0
+ *   bit 16..6   B1..B11
+ *   bit  5..0   undefined
+ */
+
+#ifndef __MCP3201_H__
+#define __MCP3201_H__
+
+#include <stdint.h>
+
+/* Store two values for each ADC reading */
+struct mcp3201_data {
+	uint16_t val1;
+	uint16_t val2;
+};
+
+/**
+ * Decode both samples of one MCP3201 frame without per-bit branches.
+ *
+ * @param frame 4 bytes as received on the bus
+ * @param data  MSB-first sample in val1, LSB-first sample in val2
+ *
+ * @retval 0 on success
+ * @retval -ENOTSUP if the null bit is not 0
+ */
+int mcp3201_decode(const uint8_t frame[4], struct mcp3201_data *data);
+
+#endif /* __MCP3201_H__ */
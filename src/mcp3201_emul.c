@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define DT_DRV_COMPAT microchip_mcp3201
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(mcp3201_emul, LOG_LEVEL_DBG);
+
+#include <errno.h>
+#include <math.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "mcp3201_emul.h"
+
+#define EMUL_NUM_CHANNELS DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT)
+
+#define MCP3201_MSB_SHIFT 17
+#define MCP3201_MAX	  0xFFF
+#define MCP3201_MID	  0x800
+
+#ifdef CONFIG_APP_MCP3201_EMUL_RECORDED
+/* Little-endian 12-bit samples, one per channel per frame in instance order */
+static const uint8_t waveform[] = {
+#include "mcp3201_waveform.inc"
+};
+
+#define WAVEFORM_FRAME_LEN (EMUL_NUM_CHANNELS * sizeof(uint16_t))
+#define WAVEFORM_FRAMES	   (sizeof(waveform) / WAVEFORM_FRAME_LEN)
+
+BUILD_ASSERT((sizeof(waveform) % WAVEFORM_FRAME_LEN) == 0,
+	     "Recorded waveform must hold a whole number of frames for every channel");
+#endif /* CONFIG_APP_MCP3201_EMUL_RECORDED */
+
+struct mcp3201_emul_data {
+	uint16_t amplitude;
+	uint32_t rng;
+};
+
+struct mcp3201_emul_cfg {
+	uint8_t ch_num;
+};
+
+static struct mcp3201_emul_data emul_data[EMUL_NUM_CHANNELS];
+
+static uint32_t xorshift32(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+/* The sample each channel holds at the given uptime */
+static int32_t sample_at(uint8_t ch_num, uint64_t us)
+{
+#ifdef CONFIG_APP_MCP3201_EMUL_RECORDED
+	uint64_t frame = ((us * CONFIG_APP_MCP3201_EMUL_RECORDED_RATE_HZ) / USEC_PER_SEC) %
+			 WAVEFORM_FRAMES;
+
+	return sys_get_le16(&waveform[(frame * WAVEFORM_FRAME_LEN) + (ch_num * sizeof(uint16_t))]);
+#else
+	struct mcp3201_emul_data *data = &emul_data[ch_num];
+	/* Position within the mains cycle, in millionths, exact for any uptime */
+	uint64_t pos = ((us % USEC_PER_SEC) * CONFIG_APP_MAINS_FREQ_HZ) % USEC_PER_SEC;
+	float angle = (2.0f * 3.14159265f * (float)pos) / (float)USEC_PER_SEC;
+	uint32_t span = (2 * CONFIG_APP_MCP3201_EMUL_NOISE) + 1;
+	int32_t noise = (int32_t)(xorshift32(&data->rng) % span) - CONFIG_APP_MCP3201_EMUL_NOISE;
+
+	return MCP3201_MID + (int32_t)(data->amplitude * sinf(angle)) + noise;
+#endif /* CONFIG_APP_MCP3201_EMUL_RECORDED */
+}
+
+/* B11..B0 after the null bit, then B1..B11 shifted out LSB first */
+static uint32_t encode_frame(uint16_t val)
+{
+	uint32_t word = (uint32_t)val << MCP3201_MSB_SHIFT;
+
+	for (int k = 1; k < 12; k++) {
+		word |= (uint32_t)((val >> k) & 1) << (MCP3201_MSB_SHIFT - k);
+	}
+
+	return word;
+}
+
+static int mcp3201_emul_io(const struct emul *target, const struct spi_config *config,
+			   const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs)
+{
+	const struct mcp3201_emul_cfg *cfg = target->cfg;
+	uint8_t frame[4];
+	int32_t val;
+
+	ARG_UNUSED(config);
+	ARG_UNUSED(tx_bufs);
+
+	if (!rx_bufs || (rx_bufs->count == 0)) {
+		return 0;
+	}
+
+	val = sample_at(cfg->ch_num, k_ticks_to_us_floor64(k_uptime_ticks()));
+	val = CLAMP(val, 0, MCP3201_MAX);
+
+	sys_put_be32(encode_frame(val), frame);
+
+	/* The ADC clocks out zeros once the frame is complete */
+	for (size_t i = 0, off = 0; i < rx_bufs->count; i++) {
+		const struct spi_buf *buf = &rx_bufs->buffers[i];
+		uint8_t *dst = buf->buf;
+
+		for (size_t j = 0; dst && (j < buf->len); j++, off++) {
+			dst[j] = (off < sizeof(frame)) ? frame[off] : 0;
+		}
+	}
+
+	return 0;
+}
+
+static const struct spi_emul_api mcp3201_emul_api = {
+	.io = mcp3201_emul_io,
+};
+
+static int mcp3201_emul_init(const struct emul *target, const struct device *parent)
+{
+	const struct mcp3201_emul_cfg *cfg = target->cfg;
+	struct mcp3201_emul_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	data->amplitude = CONFIG_APP_MCP3201_EMUL_AMPLITUDE;
+	data->rng = 0x9e3779b9U * (cfg->ch_num + 1);
+
+	LOG_DBG("Emulating mcp3201 for ch%d", cfg->ch_num);
+
+	return 0;
+}
+
+int mcp3201_emul_set_amplitude(uint8_t ch_num, uint16_t counts)
+{
+	if (ch_num >= EMUL_NUM_CHANNELS) {
+		return -EINVAL;
+	}
+
+	emul_data[ch_num].amplitude = MIN(counts, MCP3201_MID);
+
+	return 0;
+}
+
+/* The emulator is bound to a device, but the application only ever talks
+ * to the bus, so each ADC gets a device without an API.
+ */
+#define MCP3201_EMUL(inst)                                                                         \
+	DEVICE_DT_INST_DEFINE(inst, NULL, NULL, NULL, NULL, POST_KERNEL,                           \
+			      CONFIG_APPLICATION_INIT_PRIORITY, NULL);                             \
+                                                                                                   \
+	static const struct mcp3201_emul_cfg mcp3201_emul_cfg_##inst = {                           \
+		.ch_num = inst,                                                                    \
+	};                                                                                         \
+                                                                                                   \
+	EMUL_DT_INST_DEFINE(inst, mcp3201_emul_init, &emul_data[inst], &mcp3201_emul_cfg_##inst,   \
+			    &mcp3201_emul_api, NULL);
+
+DT_INST_FOREACH_STATUS_OKAY(MCP3201_EMUL)
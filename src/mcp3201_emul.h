@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * SPI emulator for the microchip,mcp3201 binding, used on native_sim.
+ * Every read returns the sample at the current uptime of either a
+ * synthetic mains sinusoid or a recorded waveform compiled into the
+ * image, encoded in the same 4-byte frame the real ADC shifts out.
+ */
+
+#ifndef __MCP3201_EMUL_H__
+#define __MCP3201_EMUL_H__
+
+#include <stdint.h>
+
+/**
+ * Set the peak amplitude of the synthetic waveform for channel ch_num, in
+ * ADC counts around mid-scale. Has no effect on a recorded waveform.
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if there is no emulated ADC for ch_num
+ */
+int mcp3201_emul_set_amplitude(uint8_t ch_num, uint16_t counts);
+
+#endif /* __MCP3201_EMUL_H__ */
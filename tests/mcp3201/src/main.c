@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2025 Golioth, Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/ztest.h>
+
+#ifndef CONFIG_BOARD_NATIVE_SIM
+#include <zephyr/timing/timing.h>
+#endif
+
+#include "mcp3201.h"
+
+#ifdef CONFIG_BOARD_NATIVE_SIM
+/* src/app_bench_host.c, linked into the native_sim runner */
+uint64_t app_bench_host_ns(void);
+#endif
+
+/* The 24 bits of a frame that are not undefined: null bit, B11..B0, B1..B11 */
+#define FRAME_PATTERNS (1U << 24)
+
+/*
+ * process_adc_reading() from app_sensors.c before mcp3201_decode()
+ * replaced it, kept verbatim as the reference.
+ */
+static int process_adc_reading(uint8_t buf_data[4], struct mcp3201_data *adc_data)
+{
+	if (buf_data[0] & 1<<5) {	/* Missing NULL bit */
+		return -ENOTSUP;
+	}
+
+	uint16_t data_msb = 0;
+	uint16_t data_lsb = 0;
+
+	data_msb = buf_data[0] & 0x1F;
+	data_msb |= (data_msb << 7) | (buf_data[1] >> 1);
+
+	for (uint8_t i = 0; i < 12; i++) {
+		bool bit_set = false;
+
+		if (i < 2) {
+			if (buf_data[1] & (1 << (1 - i))) {
+				bit_set = true;
+			}
+		} else if (i < 10) {
+			if (buf_data[2] & (1 << (2 + 7 - i))) {
+				bit_set = true;
+			}
+		} else {
+			if (buf_data[3] & (1 << (10 + 7 - i))) {
+				bit_set = true;
+			}
+		}
+		if (bit_set) {
+			data_lsb |= (1 << i);
+		}
+	}
+
+	adc_data->val1 = data_msb;
+	adc_data->val2 = data_lsb;
+
+	return 0;
+}
+
+/* Pattern p in the defined bits, with the undefined bits also varied */
+static void make_frame(uint32_t p, uint8_t frame[4])
+{
+	uint32_t word = (p << 6) | ((p & 0x3) << 30) | (~p & 0x3F);
+
+	sys_put_be32(word, frame);
+}
+
+static uint64_t now(void)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+	/* Simulated time stands still while code runs */
+	return app_bench_host_ns();
+#else
+	return timing_counter_get();
+#endif
+}
+
+static uint64_t to_ns(uint64_t t)
+{
+#ifdef CONFIG_BOARD_NATIVE_SIM
+	return t;
+#else
+	return timing_cycles_to_ns(t);
+#endif
+}
+
+ZTEST(mcp3201, test_decode_matches_reference)
+{
+	struct mcp3201_data ref, dec;
+	uint8_t frame[4];
+	int ref_err, dec_err;
+
+	for (uint32_t p = 0; p < FRAME_PATTERNS; p++) {
+		make_frame(p, frame);
+
+		ref_err = process_adc_reading(frame, &ref);
+		dec_err = mcp3201_decode(frame, &dec);
+
+		zassert_equal(dec_err, ref_err, "frame %02x%02x%02x%02x: err %d, expected %d",
+			      frame[0], frame[1], frame[2], frame[3], dec_err, ref_err);
+		if (ref_err) {
+			continue;
+		}
+
+		/* The reference also OR'ed B11..B7 into the low bits of val1 */
+		zassert_equal(dec.val1 | (frame[0] & 0x1F), ref.val1,
+			      "frame %02x%02x%02x%02x: val1 %03x, expected %03x", frame[0],
+			      frame[1], frame[2], frame[3], dec.val1, ref.val1);
+		zassert_equal(dec.val1, (sys_get_be32(frame) >> 17) & 0xFFF);
+		zassert_equal(dec.val2, ref.val2,
+			      "frame %02x%02x%02x%02x: val2 %03x, expected %03x", frame[0],
+			      frame[1], frame[2], frame[3], dec.val2, ref.val2);
+	}
+}
+
+ZTEST(mcp3201, test_decode_benchmark)
+{
+	struct mcp3201_data data;
+	uint8_t frame[4];
+	uint64_t start, ref_ns, dec_ns;
+	/* Keeps the decoded values alive so the loops are not optimized out */
+	volatile uint32_t sink = 0;
+
+	start = now();
+	for (uint32_t p = 0; p < FRAME_PATTERNS; p++) {
+		make_frame(p, frame);
+		if (process_adc_reading(frame, &data) == 0) {
+			sink += data.val1 + data.val2;
+		}
+	}
+	ref_ns = to_ns(now() - start);
+
+	start = now();
+	for (uint32_t p = 0; p < FRAME_PATTERNS; p++) {
+		make_frame(p, frame);
+		if (mcp3201_decode(frame, &data) == 0) {
+			sink += data.val1 + data.val2;
+		}
+	}
+	dec_ns = to_ns(now() - start);
+
+	/* Same format as the app_bench BENCH lines */
+	printk("BENCH {\"stage\":\"decode_reference\",\"n\":%u,\"total_ns\":%llu,"
+	       "\"mean_ns\":%llu}\n",
+	       FRAME_PATTERNS, ref_ns, ref_ns / FRAME_PATTERNS);
+	printk("BENCH {\"stage\":\"decode\",\"n\":%u,\"total_ns\":%llu,\"mean_ns\":%llu}\n",
+	       FRAME_PATTERNS, dec_ns, dec_ns / FRAME_PATTERNS);
+
+	zassert_true(dec_ns <= ref_ns, "decode took %llu ns, reference %llu ns", dec_ns,
+		     ref_ns);
+}
+
+static void *mcp3201_setup(void)
+{
+#ifndef CONFIG_BOARD_NATIVE_SIM
+	timing_init();
+	timing_start();
+#endif
+
+	return NULL;
+}
+
+ZTEST_SUITE(mcp3201, NULL, mcp3201_setup, NULL, NULL, NULL);